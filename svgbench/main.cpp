@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include "commandhistory.h"
+#include "documentgenerator.h"
+#include "manager.h"
+#include "svgloader.h"
+#include "svgwriter.h"
+
+namespace
+{
+	const int ViewWidth = 1920;
+	const int ViewHeight = 1080;
+	const int HitTests = 1000;
+	const int Selections = 100;
+	const int PenChanges = 1000;
+	const int DragSteps = 100;
+
+	// Swallows everything written to it, so serialization is measured without the disk.
+	class NullDevice :public QIODevice
+	{
+	public:
+		NullDevice()
+		{
+			open(QIODevice::WriteOnly);
+		}
+	protected:
+		virtual qint64 readData(char*, qint64) override
+		{
+			return -1;
+		}
+		virtual qint64 writeData(const char*, qint64 size) override
+		{
+			return size;
+		}
+	};
+
+	std::vector<QPointF> randomPoints(const QSizeF& page, int number, quint32 seed)
+	{
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<double> x(0, page.width());
+		std::uniform_real_distribution<double> y(0, page.height());
+		std::vector<QPointF> points(number);
+		std::generate(points.begin(), points.end(), [&]
+			{
+				return QPointF(x(random), y(random));
+			});
+		return points;
+	}
+
+	class Runner
+	{
+	public:
+		Runner(int iterations, const QString& filter)
+			: m_iterations(iterations), m_filter(filter)
+		{
+		}
+		// Runs setup untimed and body timed, once per iteration.
+		void run(const QString& name, size_t elements, int operations, const std::function<void()>& setup, const std::function<void()>& body)
+		{
+			if (!m_filter.isEmpty() && !name.contains(m_filter))
+				return;
+			std::vector<qint64> samples;
+			QElapsedTimer timer;
+			for (int i = 0; i < m_iterations; ++i)
+			{
+				if (setup)
+					setup();
+				timer.start();
+				body();
+				samples.push_back(timer.nsecsElapsed());
+			}
+			std::sort(samples.begin(), samples.end());
+			QJsonObject result;
+			result["name"] = name;
+			result["elements"] = static_cast<double>(elements);
+			result["operations"] = operations;
+			result["iterations"] = m_iterations;
+			result["minNs"] = static_cast<double>(samples.front());
+			result["medianNs"] = static_cast<double>(samples.at(samples.size() / 2));
+			result["meanNs"] = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+			result["maxNs"] = static_cast<double>(samples.back());
+			m_results.append(result);
+			std::fprintf(stderr, "%-28s %9zu %14.3f ms\n", name.toLocal8Bit().constData(), elements, samples.at(samples.size() / 2) / 1e6);
+		}
+		QJsonArray getResults() const
+		{
+			return m_results;
+		}
+	private:
+		int m_iterations;
+		QString m_filter;
+		QJsonArray m_results;
+	};
+
+	void benchmark(Runner& runner, size_t count, quint32 seed, const QString& directory, bool keepFiles)
+	{
+		CommandHistory& history = CommandHistory::getInstance();
+		DocumentGenerator generator(seed);
+		generator.setElementCount(count);
+		Manager manager;
+		generator.generate(manager);
+		QSizeF page = generator.getPageSize();
+		QImage image(ViewWidth, ViewHeight, QImage::Format_ARGB32_Premultiplied);
+
+		runner.run("paint/fit", count, 1, nullptr, [&]
+			{
+				image.fill(Qt::white);
+				QPainter painter(&image);
+				double scale = qMin(ViewWidth / page.width(), ViewHeight / page.height());
+				painter.scale(scale, scale);
+				manager.paint(&painter, QRectF(QPointF(0, 0), page));
+			});
+		runner.run("paint/view", count, 1, nullptr, [&]
+			{
+				image.fill(Qt::white);
+				QPainter painter(&image);
+				QPointF origin(page.width() / 2 - ViewWidth / 2, page.height() / 2 - ViewHeight / 2);
+				painter.translate(-origin);
+				manager.paint(&painter, QRectF(origin, QSizeF(ViewWidth, ViewHeight)));
+			});
+
+		std::vector<QPointF> points = randomPoints(page, HitTests, seed + 1);
+		runner.run("query/isItemAt", count, HitTests, nullptr, [&]
+			{
+				int hits = std::count_if(points.begin(), points.end(), [&manager](const QPointF& pos)
+					{
+						return manager.isItemAt(pos);
+					});
+				Q_UNUSED(hits);
+			});
+		std::vector<QPointF> corners = randomPoints(page, Selections, seed + 2);
+		runner.run("query/selectItems", count, Selections, nullptr, [&]
+			{
+				std::for_each(corners.begin(), corners.end(), [&manager](const QPointF& pos)
+					{
+						manager.selectItems(QRectF(pos, QSizeF(512, 512)));
+					});
+				manager.cancelSelected();
+				manager.takeDamage();
+			});
+		runner.run("query/bounds", count, 1, nullptr, [&]
+			{
+				QRectF bounds = manager.getBoundingRect();
+				Q_UNUSED(bounds);
+			});
+		runner.run("query/dragSelect", count, DragSteps, nullptr, [&]
+			{
+				// A rubber band growing from the page center to its corner, as the canvas feeds it.
+				QPointF center(page.width() / 2, page.height() / 2);
+				QRectF band(center, QSizeF(0, 0));
+				for (int step = 1; step <= DragSteps; ++step)
+				{
+					double ratio = static_cast<double>(step) / DragSteps;
+					QRectF next(center, QSizeF(page.width() / 2 * ratio, page.height() / 2 * ratio));
+					manager.selectItems(band, next);
+					manager.takeDamage();
+					band = next;
+				}
+				manager.cancelSelected();
+				manager.takeDamage();
+			});
+
+		runner.run("io/writeSvgElements", count, 1, nullptr, [&]
+			{
+				NullDevice device;
+				SvgWriter writer(&device);
+				manager.writeSvgElements(writer);
+				writer.flush();
+			});
+		QString fileName = directory + "/" + QString::number(count) + ".svg";
+		{
+			QFile file(fileName);
+			file.open(QIODevice::WriteOnly);
+			SvgWriter writer(&file);
+			manager.writeSvg(writer, page.toSize(), Qt::white);
+			writer.flush();
+		}
+		runner.run("io/load", count, 1, nullptr, [&]
+			{
+				SvgLoader loader;
+				loader.setThreadCount(1);
+				loader.load(fileName);
+				loader.takeItems();
+			});
+		runner.run("io/loadParallel", count, 1, nullptr, [&]
+			{
+				SvgLoader loader;
+				loader.setThreadCount(QThread::idealThreadCount());
+				loader.load(fileName);
+				loader.takeItems();
+			});
+		if (!keepFiles)
+			QFile::remove(fileName);
+
+		// Every mutation runs on a fresh document with an empty history.
+		std::unique_ptr<Manager> target;
+		auto fresh = [&]
+		{
+			history.clearAll();
+			target.reset(new Manager);
+			generator.generate(*target);
+		};
+		runner.run("edit/copyPaste", count, 1, fresh, [&]
+			{
+				target->selectAll();
+				target->copy(QPointF(0, 0));
+				target->paste(QPointF(16, 16));
+			});
+		runner.run("edit/undoPaste", count, 1, [&]
+			{
+				fresh();
+				target->selectAll();
+				target->copy(QPointF(0, 0));
+				target->paste(QPointF(16, 16));
+			}, [&]
+			{
+				history.undo();
+			});
+		runner.run("edit/redoPaste", count, 1, [&]
+			{
+				fresh();
+				target->selectAll();
+				target->copy(QPointF(0, 0));
+				target->paste(QPointF(16, 16));
+				history.undo();
+			}, [&]
+			{
+				history.redo();
+			});
+
+		std::vector<QPointF> picks = randomPoints(page, PenChanges, seed + 3);
+		auto changePens = [&]
+		{
+			double width = 1;
+			std::for_each(picks.begin(), picks.end(), [&](const QPointF& pos)
+				{
+					target->selectItemAt(pos);
+					target->setSelectedPenWidth(width);
+					width = width < 8 ? width + 1 : 1;
+				});
+		};
+		runner.run("edit/changePen", count, PenChanges, fresh, changePens);
+		runner.run("edit/undoPen", count, PenChanges, [&]
+			{
+				fresh();
+				changePens();
+			}, [&]
+			{
+				for (int i = 0; i < PenChanges; ++i)
+					history.undo();
+			});
+		runner.run("edit/redoPen", count, PenChanges, [&]
+			{
+				fresh();
+				changePens();
+				for (int i = 0; i < PenChanges; ++i)
+					history.undo();
+			}, [&]
+			{
+				for (int i = 0; i < PenChanges; ++i)
+					history.redo();
+			});
+		runner.run("edit/layer", count, PenChanges, fresh, [&]
+			{
+				std::for_each(picks.begin(), picks.end(), [&](const QPointF& pos)
+					{
+						target->selectItemAt(pos);
+						target->upMost();
+						target->downLayer();
+					});
+			});
+		history.clearAll();
+	}
+}
+
+// Times the document hot paths on synthetic drawings and prints the results as JSON. The drawings
+// come from DocumentGenerator with its default mix; the page grows with the element count so the
+// density stays fixed.
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("svgbench");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Benchmarks painting, queries, I/O and undo/redo of the document model.");
+	parser.addHelpOption();
+	QCommandLineOption sizesOption(QStringList() << "s" << "sizes", "Comma separated element counts.", "list", "1000,10000,100000,1000000");
+	QCommandLineOption iterationsOption(QStringList() << "n" << "iterations", "Timed runs per benchmark.", "n", "5");
+	QCommandLineOption seedOption("seed", "Seed of the synthetic documents.", "n", "1");
+	QCommandLineOption filterOption(QStringList() << "f" << "filter", "Only run benchmarks whose name contains this text.", "text");
+	QCommandLineOption outputOption(QStringList() << "o" << "output", "Write the JSON report to this file instead of stdout.", "file");
+	QCommandLineOption keepOption(QStringList() << "k" << "keep", "Keep the synthetic documents as <count>.svg in this directory.", "dir");
+	parser.addOption(sizesOption);
+	parser.addOption(iterationsOption);
+	parser.addOption(seedOption);
+	parser.addOption(filterOption);
+	parser.addOption(outputOption);
+	parser.addOption(keepOption);
+	parser.process(app);
+
+	QTemporaryDir tempDir;
+	bool keepFiles = parser.isSet(keepOption);
+	QString directory = keepFiles ? parser.value(keepOption) : tempDir.path();
+	if (keepFiles ? !QDir().mkpath(directory) : !tempDir.isValid())
+	{
+		std::fprintf(stderr, "cannot create %s\n", directory.toLocal8Bit().constData());
+		return 1;
+	}
+	quint32 seed = parser.value(seedOption).toUInt();
+	Runner runner(qMax(1, parser.value(iterationsOption).toInt()), parser.value(filterOption));
+	QStringList sizes = parser.value(sizesOption).split(',');
+	std::for_each(sizes.begin(), sizes.end(), [&](const QString& size)
+		{
+			benchmark(runner, size.toULongLong(), seed, directory, keepFiles);
+		});
+
+	QJsonObject report;
+	report["qtVersion"] = qVersion();
+	report["threads"] = QThread::idealThreadCount();
+	report["seed"] = static_cast<double>(seed);
+	report["results"] = runner.getResults();
+	QByteArray json = QJsonDocument(report).toJson();
+	if (!parser.isSet(outputOption))
+	{
+		std::fwrite(json.constData(), 1, json.size(), stdout);
+		return 0;
+	}
+	QFile file(parser.value(outputOption));
+	if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size())
+	{
+		std::fprintf(stderr, "cannot write %s\n", parser.value(outputOption).toLocal8Bit().constData());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QStringList>
+#include <QThread>
+#include <QThreadPool>
+
+#include "gzipdevice.h"
+#include "manager.h"
+#include "nativeformat.h"
+#include "pngexporter.h"
+#include "svgloader.h"
+#include "svgwriter.h"
+#include "task.h"
+#include "tracer.h"
+
+namespace
+{
+	struct Options
+	{
+		QString format;
+		QString outputDir;
+		int threads;
+		int precision;
+		int level;
+	};
+	struct Input
+	{
+		QString path;
+		// Directory of the file relative to the directory argument it was found in.
+		QString subdirectory;
+	};
+
+	QMutex outputMutex;
+
+	void report(FILE* stream, const QString& text)
+	{
+		QMutexLocker locker(&outputMutex);
+		std::fputs(text.toLocal8Bit().constData(), stream);
+		std::fputc('\n', stream);
+	}
+
+	bool isInput(const QFileInfo& info)
+	{
+		QString suffix = info.suffix().toLower();
+		return suffix == "svg" || suffix == "svgz" || suffix == NativeFormat::Suffix;
+	}
+
+	std::vector<Input> collectInputs(const QStringList& arguments)
+	{
+		std::vector<Input> inputs;
+		std::for_each(arguments.begin(), arguments.end(), [&inputs](const QString& argument)
+			{
+				QFileInfo info(argument);
+				if (!info.isDir())
+				{
+					inputs.push_back(Input{ argument, QString() });
+					return;
+				}
+				QDir root(argument);
+				QDirIterator iter(argument, QDir::Files, QDirIterator::Subdirectories);
+				while (iter.hasNext())
+				{
+					iter.next();
+					if (isInput(iter.fileInfo()))
+						inputs.push_back(Input{ iter.filePath(), root.relativeFilePath(iter.fileInfo().path()) });
+				}
+			});
+		return inputs;
+	}
+
+	// Files found in a directory argument keep their relative location under the output directory.
+	QString outputPath(const Input& input, const Options& options)
+	{
+		QFileInfo info(input.path);
+		QDir dir = options.outputDir.isEmpty() ? info.dir() : QDir(QDir(options.outputDir).filePath(input.subdirectory));
+		return QDir::cleanPath(dir.absoluteFilePath(info.completeBaseName() + "." + options.format));
+	}
+
+	// Inputs that would still write the same file, such as x.svg and x.svgz side by side, or two
+	// x.svg given by name from different directories, are rejected before any job runs.
+	bool checkOutputs(const std::vector<Input>& inputs, const Options& options)
+	{
+		std::map<QString, QString> owners;
+		bool ok = true;
+		std::for_each(inputs.begin(), inputs.end(), [&](const Input& input)
+			{
+				QString output = outputPath(input, options);
+#ifdef Q_OS_WIN
+				QString key = output.toLower();
+#else
+				QString key = output;
+#endif
+				auto inserted = owners.emplace(key, input.path);
+				if (!inserted.second)
+				{
+					report(stderr, input.path + " and " + inserted.first->second + " both convert to " + output);
+					ok = false;
+				}
+				else if (!QDir().mkpath(QFileInfo(output).path()))
+				{
+					report(stderr, "cannot create directory: " + QFileInfo(output).path());
+					ok = false;
+				}
+			});
+		return ok;
+	}
+
+	bool convert(const QString& input, const QString& output, const Options& options, QString& error)
+	{
+		TRACE_SCOPE("convert", "convert");
+		QSize pageSize;
+		QColor background(Qt::white);
+		SvgLoader loader;
+		loader.setThreadCount(options.threads);
+		// load() runs on this thread but may emit from the loader's own workers.
+		QObject::connect(&loader, &SvgLoader::pageSizeParsed, &loader, [&pageSize](int width, int height)
+			{
+				pageSize = QSize(width, height);
+			}, Qt::DirectConnection);
+		QObject::connect(&loader, &SvgLoader::backGroundColorParsed, &loader, [&background](const QColor& color)
+			{
+				background = color;
+			}, Qt::DirectConnection);
+		if (!loader.load(input))
+		{
+			error = loader.getErrorString();
+			return false;
+		}
+		Manager manager;
+		manager.addItems(loader.takeItems());
+
+		QSaveFile file(output);
+		if (!file.open(QIODevice::WriteOnly))
+		{
+			error = file.errorString();
+			return false;
+		}
+		bool ok = false;
+		if (options.format == "png")
+		{
+			PngExporter exporter(manager, pageSize, background);
+			exporter.setThreadCount(options.threads);
+			exporter.setCompressionLevel(options.level);
+			ok = exporter.exportTo(&file);
+			if (!ok)
+				error = exporter.getErrorString();
+		}
+		else if (options.format == NativeFormat::Suffix)
+		{
+			ok = NativeFormat::write(&file, manager, pageSize, background);
+		}
+		else if (options.format == "svgz")
+		{
+			GzipWriter gzip(&file, options.level);
+			gzip.open(QIODevice::WriteOnly);
+			SvgWriter writer(&gzip);
+			writer.setPrecision(options.precision);
+			manager.writeSvg(writer, pageSize, background);
+			ok = writer.flush();
+			gzip.close();
+			ok = ok && !gzip.hasError();
+		}
+		else
+		{
+			SvgWriter writer(&file);
+			writer.setPrecision(options.precision);
+			manager.writeSvg(writer, pageSize, background);
+			ok = writer.flush();
+		}
+		// An uncommitted QSaveFile is discarded, so a failed conversion never replaces an old output.
+		if (ok)
+			ok = file.commit();
+		if (!ok && error.isEmpty())
+			error = file.errorString();
+		return ok;
+	}
+}
+
+// Headless batch converter: reads .svg/.svgz/.sved files (or directories of them) and writes PNG
+// or normalized SVG. Files are converted concurrently; each conversion gets an even share of the
+// remaining cores for its own parallel parsing and PNG compression.
+int main(int argc, char* argv[])
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("svgconvert");
+	Tracer::getInstance().startFromEnvironment();
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Converts SVG drawings to PNG or normalized SVG.");
+	parser.addHelpOption();
+	QCommandLineOption formatOption(QStringList() << "f" << "format", "Output format: png, svg, svgz or sved.", "format", "png");
+	QCommandLineOption outputOption(QStringList() << "o" << "output", "Output directory (default: next to each input).", "dir");
+	QCommandLineOption jobsOption(QStringList() << "j" << "jobs", "Number of files converted at once.", "n", QString::number(QThread::idealThreadCount()));
+	QCommandLineOption precisionOption(QStringList() << "p" << "precision", "Decimals kept in SVG coordinates (default: all).", "n", "-1");
+	QCommandLineOption levelOption(QStringList() << "l" << "level", "Compression level 0-9 for png and svgz.", "n", "6");
+	parser.addOption(formatOption);
+	parser.addOption(outputOption);
+	parser.addOption(jobsOption);
+	parser.addOption(precisionOption);
+	parser.addOption(levelOption);
+	parser.addPositionalArgument("inputs", "Files or directories to convert.", "inputs...");
+	parser.process(app);
+
+	Options options;
+	options.format = parser.value(formatOption).toLower();
+	options.outputDir = parser.value(outputOption);
+	options.precision = parser.value(precisionOption).toInt();
+	options.level = qBound(0, parser.value(levelOption).toInt(), 9);
+	if (options.format != "png" && options.format != "svg" && options.format != "svgz" && options.format != NativeFormat::Suffix)
+	{
+		report(stderr, "unknown format: " + options.format);
+		return 2;
+	}
+	if (!options.outputDir.isEmpty() && !QDir().mkpath(options.outputDir))
+	{
+		report(stderr, "cannot create directory: " + options.outputDir);
+		return 2;
+	}
+	std::vector<Input> inputs = collectInputs(parser.positionalArguments());
+	if (inputs.empty())
+		parser.showHelp(2);
+	if (!checkOutputs(inputs, options))
+		return 2;
+
+	int jobs = qBound(1, parser.value(jobsOption).toInt(), static_cast<int>(inputs.size()));
+	options.threads = qMax(1, QThread::idealThreadCount() / jobs);
+
+	std::atomic<int> failed(0);
+	QThreadPool pool;
+	pool.setMaxThreadCount(jobs);
+	std::for_each(inputs.begin(), inputs.end(), [&pool, &options, &failed](const Input& input)
+		{
+			pool.start(new Task([input, &options, &failed]
+				{
+					QString output = outputPath(input, options);
+					QString error;
+					if (convert(input.path, output, options, error))
+					{
+						report(stdout, input.path + " -> " + output);
+					}
+					else
+					{
+						report(stderr, input.path + ": " + error);
+						++failed;
+					}
+				}));
+		});
+	pool.waitForDone();
+	return failed == 0 ? 0 : 1;
+}
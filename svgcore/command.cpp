@@ -0,0 +1,127 @@
+#include "command.h"
+
+#include "manager.h"
+
+Command::Command()
+{
+}
+size_t Command::getMemoryUsage() const
+{
+	return sizeof(*this);
+}
+bool Command::refersTo(const Manager*) const
+{
+	return false;
+}
+void Command::forEachId(const Manager*, const std::function<void(ElementId)>&) const
+{
+}
+
+Add::Add(Manager* manager, std::shared_ptr<Element> item)
+	: m_manager(manager)
+	, m_backup(item)
+{
+}
+void Add::redo()
+{
+	m_manager->restoreItem(m_backup);
+}
+void Add::undo()
+{
+	m_manager->detachItem(m_backup->getId());
+}
+bool Add::refersTo(const Manager* manager) const
+{
+	return m_manager == manager;
+}
+void Add::forEachId(const Manager* manager, const std::function<void(ElementId)>& visit) const
+{
+	if (m_manager == manager)
+		visit(m_backup->getId());
+}
+
+Remove::Remove(Manager* manager, std::shared_ptr<Element> item)
+	: m_manager(manager)
+	, m_backup(item)
+{
+}
+void Remove::redo()
+{
+	m_manager->detachItem(m_backup->getId());
+}
+void Remove::undo()
+{
+	m_manager->restoreItem(m_backup);
+}
+size_t Remove::getMemoryUsage() const
+{
+	return sizeof(*this) + m_backup->getMemoryUsage();
+}
+bool Remove::refersTo(const Manager* manager) const
+{
+	return m_manager == manager;
+}
+void Remove::forEachId(const Manager* manager, const std::function<void(ElementId)>& visit) const
+{
+	if (m_manager == manager)
+		visit(m_backup->getId());
+}
+
+SwapLayer::SwapLayer(Manager* manager, ElementId id1, ElementId id2)
+	: m_manager(manager)
+	, m_id1(id1)
+	, m_id2(id2)
+{
+}
+void SwapLayer::redo()
+{
+	m_manager->swapItems(m_id1, m_id2);
+}
+void SwapLayer::undo()
+{
+	m_manager->swapItems(m_id1, m_id2);
+}
+bool SwapLayer::refersTo(const Manager* manager) const
+{
+	return m_manager == manager;
+}
+void SwapLayer::forEachId(const Manager* manager, const std::function<void(ElementId)>& visit) const
+{
+	if (m_manager == manager)
+	{
+		visit(m_id1);
+		visit(m_id2);
+	}
+}
+
+ChangePen::ChangePen(Manager* manager, std::shared_ptr<Element> item, const QPen& target) :m_manager(manager), m_item(item), m_backup(item->getPen()), m_target(target)
+{
+}
+void ChangePen::redo()
+{
+	m_manager->setItemPen(m_item, m_target);
+}
+void ChangePen::undo()
+{
+	m_manager->setItemPen(m_item, m_backup);
+}
+bool ChangePen::refersTo(const Manager* manager) const
+{
+	return m_manager == manager;
+}
+
+ChangeBrush::ChangeBrush(Manager* manager, std::shared_ptr<Element> item, const QBrush& target) :m_manager(manager), m_item(item), m_backup(item->getBrush()), m_target(target)
+{
+}
+void ChangeBrush::redo()
+{
+	m_manager->setItemBrush(m_item, m_target);
+}
+void ChangeBrush::undo()
+{
+	m_manager->setItemBrush(m_item, m_backup);
+}
+bool ChangeBrush::refersTo(const Manager* manager) const
+{
+	return m_manager == manager;
+}
\ No newline at end of file
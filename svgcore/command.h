@@ -1,16 +1,15 @@
 #ifndef COMMAND_H_
 #define COMMAND_H_
 
+#include <functional>
 #include <memory>
 
 #include <QPen>
 #include <QBrush>
-#include <QSize>
-#include <QColor>
 
 #include "element.h"
 
-class Canvas;
+class Manager;
 
 class Command
 {
@@ -23,13 +22,17 @@ public:
 	virtual ~Command() = default;
 	virtual void redo() = 0;
 	virtual void undo() = 0;
+	virtual size_t getMemoryUsage() const;
+	virtual bool refersTo(const Manager* manager) const;
+	// Calls visit on every element of manager this command refers to by ID.
+	virtual void forEachId(const Manager* manager, const std::function<void(ElementId)>& visit) const;
 };
 
 class Add :public Command
 {
 public:
 	Add() = default;
-	Add(std::vector<std::shared_ptr<Element>>& refer, size_t index);
+	Add(Manager* manager, std::shared_ptr<Element> item);
 	Add(const Add&) = default;
 	Add(Add&&) = default;
 	Add& operator=(const Add&) = default;
@@ -37,17 +40,18 @@ public:
 	~Add() = default;
 	virtual void redo() override;
 	virtual void undo() override;
+	virtual bool refersTo(const Manager* manager) const override;
+	virtual void forEachId(const Manager* manager, const std::function<void(ElementId)>& visit) const override;
 private:
-	std::vector<std::shared_ptr<Element>>& m_refer;
+	Manager* m_manager;
 	std::shared_ptr<Element> m_backup;
-	size_t m_index;
 };
 
 class Remove :public Command
 {
 public:
 	Remove() = default;
-	Remove(std::vector<std::shared_ptr<Element>>& refer, size_t index);
+	Remove(Manager* manager, std::shared_ptr<Element> item);
 	Remove(const Remove&) = default;
 	Remove(Remove&&) = default;
 	Remove& operator=(const Remove&) = default;
@@ -55,17 +59,19 @@ public:
 	~Remove() = default;
 	virtual void redo() override;
 	virtual void undo() override;
+	virtual size_t getMemoryUsage() const override;
+	virtual bool refersTo(const Manager* manager) const override;
+	virtual void forEachId(const Manager* manager, const std::function<void(ElementId)>& visit) const override;
 private:
-	std::vector<std::shared_ptr<Element>>& m_refer;
+	Manager* m_manager;
 	std::shared_ptr<Element> m_backup;
-	size_t m_index;
 };
 
 class SwapLayer :public Command
 {
 public:
 	SwapLayer() = default;
-	SwapLayer(std::vector<std::shared_ptr<Element>>& refer, size_t index1, size_t index2);
+	SwapLayer(Manager* manager, ElementId id1, ElementId id2);
 	SwapLayer(const SwapLayer&) = default;
 	SwapLayer(SwapLayer&&) = default;
 	SwapLayer& operator=(const SwapLayer&) = default;
@@ -73,17 +79,19 @@ public:
 	~SwapLayer() = default;
 	virtual void redo() override;
 	virtual void undo() override;
+	virtual bool refersTo(const Manager* manager) const override;
+	virtual void forEachId(const Manager* manager, const std::function<void(ElementId)>& visit) const override;
 private:
-	std::vector<std::shared_ptr<Element>>& m_refer;
-	size_t m_index1;
-	size_t m_index2;
+	Manager* m_manager;
+	ElementId m_id1;
+	ElementId m_id2;
 };
 
 class ChangePen :public Command
 {
 public:
 	ChangePen() = default;
-	ChangePen(std::shared_ptr<Element> item, const QPen& target);
+	ChangePen(Manager* manager, std::shared_ptr<Element> item, const QPen& target);
 	ChangePen(const ChangePen&) = default;
 	ChangePen(ChangePen&&) = default;
 	ChangePen& operator=(const ChangePen&) = default;
@@ -91,7 +99,9 @@ public:
 	~ChangePen() = default;
 	virtual void redo() override;
 	virtual void undo() override;
+	virtual bool refersTo(const Manager* manager) const override;
 private:
+	Manager* m_manager;
 	std::shared_ptr<Element> m_item;
 	QPen m_backup;
 	QPen m_target;
@@ -101,7 +111,7 @@ class ChangeBrush :public Command
 {
 public:
 	ChangeBrush() = default;
-	ChangeBrush(std::shared_ptr<Element> item, const QBrush& target);
+	ChangeBrush(Manager* manager, std::shared_ptr<Element> item, const QBrush& target);
 	ChangeBrush(const ChangeBrush&) = default;
 	ChangeBrush(ChangeBrush&&) = default;
 	ChangeBrush& operator=(const ChangeBrush&) = default;
@@ -109,63 +119,11 @@ public:
 	~ChangeBrush() = default;
 	virtual void redo() override;
 	virtual void undo() override;
+	virtual bool refersTo(const Manager* manager) const override;
 private:
+	Manager* m_manager;
 	std::shared_ptr<Element> m_item;
 	QBrush m_backup;
 	QBrush m_target;
 };
-
-class ChangeCanvasSize :public Command
-{
-public:
-	ChangeCanvasSize() = default;
-	ChangeCanvasSize(Canvas* canvas, const QSize& target);
-	ChangeCanvasSize(const ChangeCanvasSize&) = default;
-	ChangeCanvasSize(ChangeCanvasSize&&) = default;
-	ChangeCanvasSize& operator=(const ChangeCanvasSize&) = default;
-	ChangeCanvasSize& operator=(ChangeCanvasSize&&) = default;
-	~ChangeCanvasSize() = default;
-	virtual void redo() override;
-	virtual void undo() override;
-private:
-	Canvas* m_canvas;
-	QSize m_backup;
-	QSize m_target;
-};
-
-class ChangeScale :public Command
-{
-public:
-	ChangeScale() = default;
-	ChangeScale(Canvas * canvas, double target);
-	ChangeScale(const ChangeScale&) = default;
-	ChangeScale(ChangeScale&&) = default;
-	ChangeScale& operator=(const ChangeScale&) = default;
-	ChangeScale& operator=(ChangeScale&&) = default;
-	~ChangeScale() = default;
-	virtual void redo() override;
-	virtual void undo() override;
-private:
-	Canvas* m_canvas;
-	double m_backup;
-	double m_target;
-};
-
-class ChangeBackGroundColor :public Command
-{
-public:
-	ChangeBackGroundColor() = default;
-	ChangeBackGroundColor(Canvas * canvas, const QColor& target);
-	ChangeBackGroundColor(const ChangeBackGroundColor&) = default;
-	ChangeBackGroundColor(ChangeBackGroundColor&&) = default;
-	ChangeBackGroundColor& operator=(const ChangeBackGroundColor&) = default;
-	ChangeBackGroundColor& operator=(ChangeBackGroundColor&&) = default;
-	~ChangeBackGroundColor() = default;
-	virtual void redo() override;
-	virtual void undo() override;
-private:
-	Canvas* m_canvas;
-	QColor m_backup;
-	QColor m_target;
-};
 #endif // !COMMAND_H_
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "commandhistory.h"
+
+#include "tracer.h"
+
+CommandHistory& CommandHistory::getInstance()
+{
+	static CommandHistory instance;
+	return instance;
+}
+CommandHistory::CommandHistory()
+	: m_index(-1)
+	, m_numIndex(-1)
+	, m_memory(0)
+	, m_trimCount(0)
+{
+}
+void CommandHistory::addCommand(std::shared_ptr<Command> command)
+{
+	clearAfterIndex();
+	m_memory += command->getMemoryUsage();
+	m_did.push_back(command);
+	m_num.push_back(1);
+	++m_index;
+	++m_numIndex;
+}
+void CommandHistory::addCommands(std::vector<std::shared_ptr<Command>> dids)
+{
+	clearAfterIndex();
+	std::for_each(dids.begin(), dids.end(), [this](const std::shared_ptr<Command>& command)
+		{
+			m_memory += command->getMemoryUsage();
+		});
+	copy(dids.begin(), dids.end(), std::back_inserter(m_did));
+	m_num.push_back(dids.size());
+	m_index += dids.size();
+	++m_numIndex;
+}
+void CommandHistory::clearAfterIndex()
+{
+	if (m_index + 1 + m_did.begin() != m_did.end())
+	{
+		std::for_each(m_did.begin() + 1 + m_index, m_did.end(), [this](const std::shared_ptr<Command>& command)
+			{
+				m_memory -= command->getMemoryUsage();
+			});
+		m_did.erase(m_did.begin() + 1 + m_index, m_did.end());
+		++m_trimCount;
+	}
+	if (m_numIndex + 1 + m_num.begin() != m_num.end())
+		m_num.erase(m_num.begin() + 1 + m_numIndex, m_num.end());
+}
+void CommandHistory::clearAll()
+{
+	m_index = -1;
+	m_numIndex = -1;
+	m_did.clear();
+	m_num.clear();
+	m_memory = 0;
+	++m_trimCount;
+}
+// Drops the commands that refer to manager, which is going away, and the groups left empty. The
+// undo position stays after the same remaining commands.
+void CommandHistory::removeCommands(const Manager* manager)
+{
+	std::vector<std::shared_ptr<Command>> did;
+	std::vector<size_t> num;
+	long long index = -1;
+	long long numIndex = -1;
+	size_t first = 0;
+	for (size_t group = 0; group < m_num.size(); ++group)
+	{
+		size_t kept = 0;
+		std::for_each(m_did.begin() + first, m_did.begin() + first + m_num.at(group), [&](const std::shared_ptr<Command>& command)
+			{
+				if (command->refersTo(manager))
+				{
+					m_memory -= command->getMemoryUsage();
+					return;
+				}
+				did.push_back(command);
+				++kept;
+			});
+		first += m_num.at(group);
+		if (kept == 0)
+			continue;
+		num.push_back(kept);
+		if (static_cast<long long>(group) <= m_numIndex)
+		{
+			index = static_cast<long long>(did.size()) - 1;
+			numIndex = static_cast<long long>(num.size()) - 1;
+		}
+	}
+	m_did.swap(did);
+	m_num.swap(num);
+	m_index = index;
+	m_numIndex = numIndex;
+}
+void CommandHistory::undo()
+{
+	TRACE_SCOPE("CommandHistory::undo", "history");
+	if (m_numIndex < 0)
+		return;
+	if (m_num.at(m_numIndex) == 1)
+	{
+		m_did.at(m_index)->undo();
+		--m_index;
+	}
+	else
+	{
+		auto rbegin = std::make_reverse_iterator(m_did.begin() + 1 + m_index);
+		auto rend = rbegin + m_num.at(m_numIndex);
+		std::for_each(rbegin, rend, [](std::shared_ptr<Command> iter)
+			{
+				iter->undo();
+			});
+		m_index -= m_num.at(m_numIndex);
+	}
+	--m_numIndex;
+}
+void CommandHistory::redo()
+{
+	TRACE_SCOPE("CommandHistory::redo", "history");
+	if (m_num.empty())
+		return;
+	if (m_num.begin() + 1 + m_numIndex == m_num.end())
+		return;
+	++m_numIndex;
+	if (m_num.at(m_numIndex) == 1)
+	{
+		++m_index;
+		m_did.at(m_index)->redo();
+	}
+	else
+	{
+		auto begin = m_did.begin() + 1 + m_index;
+		auto end = begin + m_num.at(m_numIndex);
+		std::for_each(begin, end, [](std::shared_ptr<Command> iter)
+			{
+				iter->redo();
+			});
+		m_index += m_num.at(m_numIndex);
+	}
+}
+size_t CommandHistory::getUndoDepth() const
+{
+	return static_cast<size_t>(m_numIndex + 1);
+}
+size_t CommandHistory::getCommandCount() const
+{
+	return m_did.size();
+}
+size_t CommandHistory::getMemoryUsage() const
+{
+	return m_memory;
+}
+// Counts the times commands were dropped without being undone, which may unpin removed elements.
+size_t CommandHistory::getTrimCount() const
+{
+	return m_trimCount;
+}
+void CommandHistory::forEachId(const Manager* manager, const std::function<void(ElementId)>& visit) const
+{
+	std::for_each(m_did.begin(), m_did.end(), [manager, &visit](const std::shared_ptr<Command>& command)
+		{
+			command->forEachId(manager, visit);
+		});
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef COMMANDHISTORY_H_
 #define COMMANDHISTORY_H_
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -17,8 +18,14 @@ public:
 	void addCommands(std::vector<std::shared_ptr<Command>> dids);
 	void clearAfterIndex();
 	void clearAll();
+	void removeCommands(const Manager* manager);
 	void undo();
 	void redo();
+	size_t getUndoDepth() const;
+	size_t getCommandCount() const;
+	size_t getMemoryUsage() const;
+	size_t getTrimCount() const;
+	void forEachId(const Manager* manager, const std::function<void(ElementId)>& visit) const;
 private:
 	CommandHistory();
 	CommandHistory(CommandHistory&) = delete;
@@ -29,6 +36,8 @@ private:
 	long long m_index;
 	std::vector<size_t> m_num;
 	long long m_numIndex;
+	size_t m_memory;
+	size_t m_trimCount;
 };
 #endif // !COMMANDHISTORY_H_
 
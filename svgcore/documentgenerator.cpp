@@ -0,0 +1,156 @@
+#include "documentgenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include <QColor>
+
+#include "manager.h"
+
+namespace
+{
+	const int PaletteSize = 16;
+	const int MaxPointCount = 1 << 20;
+	const double Pi = 3.14159265358979323846;
+}
+
+DocumentGenerator::DocumentGenerator(quint32 seed)
+	: m_seed(seed), m_count(1000), m_typeWeights({ 0, 4, 2, 2, 2, 1, 1, 1 })
+	, m_pointMedian(200), m_pointSpread(1), m_clusterCount(16), m_clusterRadius(0), m_clusterRatio(0.8)
+	, m_layerCount(3), m_shapeSize(16)
+{
+}
+void DocumentGenerator::setSeed(quint32 seed)
+{
+	m_seed = seed;
+}
+void DocumentGenerator::setElementCount(size_t count)
+{
+	m_count = count;
+}
+void DocumentGenerator::setPageSize(const QSizeF& size)
+{
+	m_pageSize = size;
+}
+void DocumentGenerator::setTypeWeight(Type type, double weight)
+{
+	if (type != Type::None)
+		m_typeWeights.at(static_cast<size_t>(type)) = qMax(0.0, weight);
+}
+void DocumentGenerator::setPointCount(int median, double spread)
+{
+	m_pointMedian = qBound(2, median, MaxPointCount);
+	m_pointSpread = qMax(0.0, spread);
+}
+void DocumentGenerator::setClusters(int count, double radius, double ratio)
+{
+	m_clusterCount = qMax(0, count);
+	m_clusterRadius = radius;
+	m_clusterRatio = qBound(0.0, ratio, 1.0);
+}
+void DocumentGenerator::setLayerCount(int count)
+{
+	m_layerCount = qBound(1, count, 16);
+}
+void DocumentGenerator::setShapeSize(double size)
+{
+	m_shapeSize = qMax(1.0, size);
+}
+size_t DocumentGenerator::getElementCount() const
+{
+	return m_count;
+}
+QSizeF DocumentGenerator::getPageSize() const
+{
+	if (!m_pageSize.isEmpty())
+		return m_pageSize;
+	// Without an explicit page the density stays the same whatever the element count.
+	double side = qMax(1024.0, 64 * std::sqrt(static_cast<double>(m_count)));
+	return QSizeF(side, side);
+}
+std::vector<ElementBase> DocumentGenerator::generate() const
+{
+	std::vector<ElementBase> items;
+	items.reserve(m_count);
+	build([&items](const ElementBase& item)
+		{
+			items.push_back(item);
+		});
+	return items;
+}
+void DocumentGenerator::generate(Manager& manager) const
+{
+	build([&manager](const ElementBase& item)
+		{
+			manager.createItem(item.getType(), item.getBoungdingRect(), item.getPath(), item.getPen(), item.getBrush());
+		});
+}
+void DocumentGenerator::build(const std::function<void(const ElementBase&)>& sink) const
+{
+	static const double widths[] = { 0.5, 1, 1, 2, 2, 3, 5, 8 };
+	static const Qt::PenStyle styles[] = { Qt::DashLine, Qt::DotLine, Qt::DashDotLine, Qt::DashDotDotLine };
+	std::mt19937 random(m_seed);
+	std::uniform_real_distribution<double> unit(0, 1);
+	std::normal_distribution<double> normal(0, 1);
+	std::discrete_distribution<int> types(m_typeWeights.begin(), m_typeWeights.end());
+	std::lognormal_distribution<double> points(std::log(static_cast<double>(m_pointMedian)), m_pointSpread);
+	std::lognormal_distribution<double> extent(0, 0.5);
+	QSizeF page = getPageSize();
+
+	std::vector<QColor> palette(PaletteSize);
+	std::generate(palette.begin(), palette.end(), [&]
+		{
+			return QColor::fromHsvF(unit(random), 0.3 + 0.7 * unit(random), 0.4 + 0.6 * unit(random));
+		});
+	std::vector<QPointF> centers(m_clusterCount);
+	std::generate(centers.begin(), centers.end(), [&]
+		{
+			return QPointF(unit(random) * page.width(), unit(random) * page.height());
+		});
+	double radius = m_clusterRadius > 0 ? m_clusterRadius : qMin(page.width(), page.height()) / 16;
+
+	for (size_t i = 0; i < m_count; ++i)
+	{
+		int layer = static_cast<int>(i * m_layerCount / m_count);
+		double scale = m_shapeSize * std::ldexp(1.0, m_layerCount - 1 - layer);
+		QPointF pos;
+		if (!centers.empty() && unit(random) < m_clusterRatio)
+			pos = centers.at(random() % centers.size()) + QPointF(normal(random), normal(random)) * radius;
+		else
+			pos = QPointF(unit(random) * page.width(), unit(random) * page.height());
+		pos = QPointF(qBound(0.0, pos.x(), page.width()), qBound(0.0, pos.y(), page.height()));
+
+		Type type = static_cast<Type>(types(random));
+		QRectF rect;
+		QPainterPath path;
+		if (type == Type::Path)
+		{
+			int number = static_cast<int>(qBound(2.0, points(random), static_cast<double>(MaxPointCount)));
+			double heading = unit(random) * 2 * Pi;
+			double step = qMax(1.0, scale / 8);
+			path.moveTo(pos);
+			for (int n = 1; n < number; ++n)
+			{
+				heading += normal(random) * 0.35;
+				pos += QPointF(std::cos(heading), std::sin(heading)) * step * (0.5 + unit(random));
+				path.lineTo(pos);
+			}
+			rect = path.boundingRect();
+		}
+		else if (type == Type::Line)
+		{
+			rect = QRectF(pos, pos + QPointF(normal(random), normal(random)) * scale);
+		}
+		else
+		{
+			QSizeF size(scale * extent(random), scale * extent(random));
+			rect = QRectF(pos - QPointF(size.width() / 2, size.height() / 2), size);
+		}
+		Qt::PenStyle style = unit(random) < 0.85 ? Qt::SolidLine : styles[random() % 4];
+		QPen pen(palette.at(random() % PaletteSize), widths[random() % 8], style);
+		bool isFilled = type != Type::Path && type != Type::Line && unit(random) < 0.7;
+		QBrush brush(isFilled ? palette.at(random() % PaletteSize) : QColor(Qt::transparent));
+		sink(ElementBase(type, rect, path, pen, brush));
+	}
+}
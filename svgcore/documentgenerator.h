@@ -0,0 +1,55 @@
+#ifndef DOCUMENTGENERATOR_H_
+#define DOCUMENTGENERATOR_H_
+
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <QPointF>
+#include <QSizeF>
+
+#include "element.h"
+
+class Manager;
+
+// Builds seeded synthetic drawings for benchmarks and profiling; with the same standard library the
+// same seed and settings always give the same document. Elements are laid down in layers from large background shapes to small
+// details, most of them gathered around cluster centers. Freehand paths follow a smooth random
+// walk whose point count is log-normally distributed around the given median.
+class DocumentGenerator
+{
+public:
+	explicit DocumentGenerator(quint32 seed = 1);
+	DocumentGenerator(const DocumentGenerator&) = default;
+	DocumentGenerator(DocumentGenerator&&) = default;
+	DocumentGenerator& operator=(const DocumentGenerator&) = default;
+	DocumentGenerator& operator=(DocumentGenerator&&) = default;
+	~DocumentGenerator() = default;
+	void setSeed(quint32 seed);
+	void setElementCount(size_t count);
+	void setPageSize(const QSizeF& size);
+	void setTypeWeight(Type type, double weight);
+	void setPointCount(int median, double spread);
+	void setClusters(int count, double radius, double ratio);
+	void setLayerCount(int count);
+	void setShapeSize(double size);
+	size_t getElementCount() const;
+	QSizeF getPageSize() const;
+	std::vector<ElementBase> generate() const;
+	void generate(Manager& manager) const;
+private:
+	void build(const std::function<void(const ElementBase&)>& sink) const;
+	quint32 m_seed;
+	size_t m_count;
+	QSizeF m_pageSize;
+	std::vector<double> m_typeWeights;
+	int m_pointMedian;
+	double m_pointSpread;
+	int m_clusterCount;
+	double m_clusterRadius;
+	double m_clusterRatio;
+	int m_layerCount;
+	double m_shapeSize;
+};
+
+#endif // !DOCUMENTGENERATOR_H_
@@ -1,5 +1,13 @@
 #include "element.h"
 
+#include <algorithm>
+
+namespace
+{
+	const int MaxLodLevel = 6;
+	const size_t MinLodPoints = 16;
+}
+
 ElementBase::ElementBase(Type type)
 	: m_type(type)
 	, m_boundingRect(QRectF())
@@ -56,59 +64,72 @@ void ElementBase::setBrush(const QBrush& brush)
 
 Element::Element(Type type, const QPointF& pos)
 	: ElementBase(type)
+	, m_id(0)
 	, m_edge(Edge::BottomRight)
-	, m_selected(false)
 {
 	m_boundingRect = QRectF(pos.x(), pos.y(), 1, 1);
 }
 Element::Element(const ElementBase& item)
 	: ElementBase(item)
+	, m_id(0)
 	, m_edge(Edge::NoEdge)
-	, m_selected(false)
 {
 }
-std::string Element::toSvgPenAndBrushAttribute() const
+void Element::writeSvgPenAndBrush(SvgWriter& writer) const
 {
-	std::string attribute;
-	attribute += ("stroke=\"" + m_pen.color().name().toStdString() + "\" ");
-	attribute += ("stroke-width=\"" + std::to_string(m_pen.widthF()) + "\" ");
+	writer << "stroke=\"" << m_pen.color().name() << "\" ";
+	writer << "stroke-width=\"" << m_pen.widthF() << "\" ";
 	switch (m_pen.style())
 	{
 	case Qt::PenStyle::DashLine:
-		attribute += ("stroke-dasharray=\"10,5\" ");
+		writer << "stroke-dasharray=\"10,5\" ";
 		break;
 	case Qt::PenStyle::DotLine:
-		attribute += ("stroke-dasharray=\"1,5\" ");
+		writer << "stroke-dasharray=\"1,5\" ";
 		break;
 	case Qt::PenStyle::DashDotLine:
-		attribute += ("stroke-dasharray=\"10,5,1,5\" ");
+		writer << "stroke-dasharray=\"10,5,1,5\" ";
 		break;
 	case Qt::PenStyle::DashDotDotLine:
-		attribute += ("stroke-dasharray=\"10,5,1,5,1,5\" ");
+		writer << "stroke-dasharray=\"10,5,1,5,1,5\" ";
 		break;
 	default:
 		break;
 	}
 	if (m_brush.color() != Qt::transparent)
-		attribute += ("fill=\"" + m_brush.color().name().toStdString() + "\" ");
+		writer << "fill=\"" << m_brush.color().name() << "\" ";
 	else
-		attribute += ("fill=\"transparent\" ");
-	return attribute;
+		writer << "fill=\"transparent\" ";
 }
-void Element::setSelected(bool selected)
+ElementId Element::getId() const
 {
-	m_selected = selected;
-	if (!m_selected)
-		m_edge = Edge::NoEdge;
+	return m_id;
 }
-bool Element::isSelected() const
+void Element::setId(ElementId id)
 {
-	return m_selected;
+	m_id = id;
+}
+void Element::clearEdge()
+{
+	m_edge = Edge::NoEdge;
 }
 bool Element::isPosIn(const QPointF& point) const
 {
 	return m_edge != Edge::NoEdge ? m_boundingRect.normalized().adjusted(-5, -5, 5, 5).contains(point) : m_boundingRect.normalized().contains(point);
 }
+QRectF Element::getDirtyRect() const
+{
+	double margin = m_pen.widthF() + 2;
+	return m_boundingRect.normalized().adjusted(-margin, -margin, margin, margin);
+}
+const QPainterPath& Element::getLodPath(double) const
+{
+	return m_path;
+}
+size_t Element::getMemoryUsage() const
+{
+	return sizeof(*this) + m_path.elementCount() * sizeof(QPainterPath::Element);
+}
 Edge Element::recognizeMousePos(const QPointF& pos)
 {
 	double top = m_boundingRect.top();
@@ -164,6 +185,10 @@ void Element::drawShape(const QPointF& pos)
 {
 	changeShape(Edge::BottomRight, pos);
 }
+bool Element::finishShape()
+{
+	return false;
+}
 void Element::changeShape(Edge edge, const QPointF& pos)
 {
 	switch (edge)
@@ -206,9 +231,13 @@ void Element::translate(const QPointF& start, const QPointF& end)
 	}
 }
 
-Path::Path(const QPointF& pos) :Element(Type::Path, pos)
+Path::Path(const QPointF& pos) :Path(pos, StrokeFilter())
+{
+}
+Path::Path(const QPointF& pos, const StrokeFilter& filter) :Element(Type::Path, pos), m_filter(filter)
 {
 	m_points.push_back(pos);
+	m_filter.begin(pos);
 }
 Path::Path(const ElementBase& element) : Element(element)
 {
@@ -218,9 +247,46 @@ Path::Path(const ElementBase& element) : Element(element)
 }
 void Path::drawShape(const QPointF& pos)
 {
-	m_points.push_back(pos);
-	updatePath();
-	m_boundingRect = m_path.boundingRect();
+	QPointF point;
+	Capture capture = m_filter.push(pos, point);
+	capturePoint(capture, point);
+}
+bool Path::finishShape()
+{
+	QPointF point;
+	Capture capture = m_filter.finish(point);
+	return capturePoint(capture, point);
+}
+bool Path::capturePoint(Capture capture, const QPointF& point)
+{
+	switch (capture)
+	{
+	case Capture::Append:
+		if (m_path.elementCount() == 0)
+			m_path.moveTo(m_points.front());
+		m_points.push_back(point);
+		m_path.lineTo(point);
+		break;
+	case Capture::Replace:
+		m_points.back() = point;
+		m_path.setElementPositionAt(m_path.elementCount() - 1, point.x(), point.y());
+		break;
+	default:
+		return false;
+	}
+	m_lods.clear();
+	if (m_points.size() == 2)
+	{
+		m_boundingRect = QRectF(m_points.front(), point).normalized();
+	}
+	else
+	{
+		m_boundingRect.setLeft(qMin(m_boundingRect.left(), point.x()));
+		m_boundingRect.setTop(qMin(m_boundingRect.top(), point.y()));
+		m_boundingRect.setRight(qMax(m_boundingRect.right(), point.x()));
+		m_boundingRect.setBottom(qMax(m_boundingRect.bottom(), point.y()));
+	}
+	return true;
 }
 void Path::changeShape(Edge edge, const QPointF& pos)
 {
@@ -252,9 +318,11 @@ void Path::translate(const QPointF& start, const QPointF& end)
 		iter.setX(iter.x() + end.x() - start.x());
 		iter.setY(iter.y() + end.y() - start.y());
 	}
+	m_lods.clear();
 }
 void Path::updatePath()
 {
+	m_lods.clear();
 	m_path = QPainterPath();
 	m_path.moveTo(m_points[0]);
 	std::for_each(m_points.begin() + 1, m_points.end(), [this](const QPointF& point)
@@ -262,23 +330,76 @@ void Path::updatePath()
 			m_path.lineTo(point);
 		});
 }
+const QPainterPath& Path::getLodPath(double scale) const
+{
+	int level = 0;
+	while (level < MaxLodLevel && scale * (2 << level) <= 1)
+		++level;
+	if (level == 0 || m_points.size() < MinLodPoints)
+		return m_path;
+	if (m_lods.empty())
+		m_lods.resize(MaxLodLevel);
+	QPainterPath& lod = m_lods.at(level - 1);
+	if (lod.elementCount() == 0)
+	{
+		double tolerance = 0.5 * (1 << level);
+		std::vector<bool> keep(m_points.size(), false);
+		keep.front() = true;
+		keep.back() = true;
+		std::vector<std::pair<size_t, size_t>> ranges{ { 0, m_points.size() - 1 } };
+		while (!ranges.empty())
+		{
+			size_t first = ranges.back().first;
+			size_t last = ranges.back().second;
+			ranges.pop_back();
+			size_t farthest = first;
+			double distance = tolerance;
+			for (size_t i = first + 1; i < last; ++i)
+			{
+				double d = distanceToSegment(m_points.at(i), m_points.at(first), m_points.at(last));
+				if (d > distance)
+				{
+					distance = d;
+					farthest = i;
+				}
+			}
+			if (farthest != first)
+			{
+				keep.at(farthest) = true;
+				ranges.push_back({ first, farthest });
+				ranges.push_back({ farthest, last });
+			}
+		}
+		lod.moveTo(m_points.front());
+		for (size_t i = 1; i < m_points.size(); ++i)
+			if (keep.at(i))
+				lod.lineTo(m_points.at(i));
+	}
+	return lod;
+}
+size_t Path::getMemoryUsage() const
+{
+	size_t size = Element::getMemoryUsage() + sizeof(Path) - sizeof(Element) + m_points.capacity() * sizeof(QPointF);
+	std::for_each(m_lods.begin(), m_lods.end(), [&size](const QPainterPath& lod)
+		{
+			size += sizeof(lod) + lod.elementCount() * sizeof(QPainterPath::Element);
+		});
+	return size;
+}
 const std::vector<QPointF>& Path::getPoints() const
 {
 	return m_points;
 }
-std::string Path::toSvgElement() const
+void Path::writeSvgElement(SvgWriter& writer) const
 {
-	std::string path = "<path d=\"M";
-	path += (std::to_string(m_path.elementAt(0).x) + "," + std::to_string(m_path.elementAt(0).y));
-	for (int i = 0; i < m_path.elementCount(); ++i)
-	{
-		path += ("L" + std::to_string(m_path.elementAt(i).x))
-			+ "," + std::to_string((m_path.elementAt(i).y));
-	}
-	path += "\" ";
-	path += toSvgPenAndBrushAttribute();
-	path += "/>";
-	return path;
+	if (m_path.elementCount() == 0)
+		return;
+	writer << "<path d=\"M" << QPointF(m_path.elementAt(0));
+	for (int i = 1; i < m_path.elementCount(); ++i)
+		writer << 'L' << QPointF(m_path.elementAt(i));
+	writer << "\" ";
+	writeSvgPenAndBrush(writer);
+	writer << "/>";
 }
 
 Line::Line(const QPointF& pos) :Element(Type::Line, pos)
@@ -294,16 +415,15 @@ void Line::updatePath()
 	m_path.moveTo(m_boundingRect.topLeft());
 	m_path.lineTo(m_boundingRect.bottomRight());
 }
-std::string Line::toSvgElement() const
+void Line::writeSvgElement(SvgWriter& writer) const
 {
-	std::string line = "<line ";
-	line += ("x1=\"" + std::to_string(m_boundingRect.topLeft().x()) + "\" ");
-	line += ("y1=\"" + std::to_string(m_boundingRect.topLeft().y()) + "\" ");
-	line += ("x2=\"" + std::to_string(m_boundingRect.bottomRight().x()) + "\" ");
-	line += ("y2=\"" + std::to_string(m_boundingRect.bottomRight().y()) + "\" ");
-	line += toSvgPenAndBrushAttribute();
-	line += "/>";
-	return line;
+	writer << "<line ";
+	writer << "x1=\"" << m_boundingRect.topLeft().x() << "\" ";
+	writer << "y1=\"" << m_boundingRect.topLeft().y() << "\" ";
+	writer << "x2=\"" << m_boundingRect.bottomRight().x() << "\" ";
+	writer << "y2=\"" << m_boundingRect.bottomRight().y() << "\" ";
+	writeSvgPenAndBrush(writer);
+	writer << "/>";
 }
 
 Rect::Rect(const QPointF& pos) : Element(Type::Rect, pos)
@@ -318,16 +438,16 @@ void Rect::updatePath()
 	m_path = QPainterPath();
 	m_path.addRect(m_boundingRect);
 }
-std::string Rect::toSvgElement() const
+void Rect::writeSvgElement(SvgWriter& writer) const
 {
-	std::string rect = "<rect ";
-	rect += ("x=\"" + std::to_string(m_boundingRect.normalized().topLeft().x()) + "\" ");
-	rect += ("y=\"" + std::to_string(m_boundingRect.normalized().topLeft().y()) + "\" ");
-	rect += ("width=\"" + std::to_string(m_boundingRect.normalized().width()) + "\" ");
-	rect += ("height=\"" + std::to_string(m_boundingRect.normalized().height()) + "\" ");
-	rect += toSvgPenAndBrushAttribute();
-	rect += "/>";
-	return rect;
+	QRectF rect = m_boundingRect.normalized();
+	writer << "<rect ";
+	writer << "x=\"" << rect.topLeft().x() << "\" ";
+	writer << "y=\"" << rect.topLeft().y() << "\" ";
+	writer << "width=\"" << rect.width() << "\" ";
+	writer << "height=\"" << rect.height() << "\" ";
+	writeSvgPenAndBrush(writer);
+	writer << "/>";
 }
 
 Ellipse::Ellipse(const QPointF& pos) : Element(Type::Ellipse, pos)
@@ -342,16 +462,16 @@ void Ellipse::updatePath()
 	m_path = QPainterPath();
 	m_path.addEllipse(m_boundingRect);
 }
-std::string Ellipse::toSvgElement() const
+void Ellipse::writeSvgElement(SvgWriter& writer) const
 {
-	std::string ellipse = "<ellipse ";
-	ellipse += ("cx=\"" + std::to_string(m_boundingRect.normalized().topLeft().x() + m_boundingRect.normalized().width() / 2) + "\" ");
-	ellipse += ("cy=\"" + std::to_string(m_boundingRect.normalized().topLeft().y() + m_boundingRect.normalized().height() / 2) + "\" ");
-	ellipse += ("rx=\"" + std::to_string(m_boundingRect.normalized().width() / 2) + "\" ");
-	ellipse += ("ry=\"" + std::to_string(m_boundingRect.normalized().height() / 2) + "\" ");
-	ellipse += toSvgPenAndBrushAttribute();
-	ellipse += "/>";
-	return ellipse;
+	QRectF rect = m_boundingRect.normalized();
+	writer << "<ellipse ";
+	writer << "cx=\"" << rect.topLeft().x() + rect.width() / 2 << "\" ";
+	writer << "cy=\"" << rect.topLeft().y() + rect.height() / 2 << "\" ";
+	writer << "rx=\"" << rect.width() / 2 << "\" ";
+	writer << "ry=\"" << rect.height() / 2 << "\" ";
+	writeSvgPenAndBrush(writer);
+	writer << "/>";
 }
 
 Pentagon::Pentagon(const QPointF& pos) : Element(Type::Pentagon, pos)
@@ -375,21 +495,20 @@ void Pentagon::updatePath()
 	m_path.lineTo(x1, y1 + (y2 - y1) * 7 / 18);
 	m_path.closeSubpath();
 }
-std::string Pentagon::toSvgElement() const
+void Pentagon::writeSvgElement(SvgWriter& writer) const
 {
-	std::string pentagon = "<path d=";
 	double x1 = m_boundingRect.topLeft().x();
 	double y1 = m_boundingRect.topLeft().y();
 	double x2 = m_boundingRect.bottomRight().x();
 	double y2 = m_boundingRect.bottomRight().y();
-	pentagon += ("\"M" + std::to_string((x1 + x2) / 2) + "," + std::to_string(y1));
-	pentagon += ("L" + std::to_string(x2) + "," + std::to_string(y1 + (y2 - y1) * 7 / 18));
-	pentagon += ("L" + std::to_string(x1 + (x2 - x1) * 15.4 / 19) + "," + std::to_string(y2));
-	pentagon += ("L" + std::to_string(x1 + (x2 - x1) * 3.6 / 19) + "," + std::to_string(y2));
-	pentagon += ("L" + std::to_string(x1) + "," + std::to_string(y1 + (y2 - y1) * 7 / 18) + "Z\" ");
-	pentagon += toSvgPenAndBrushAttribute();
-	pentagon += "/>";
-	return pentagon;
+	writer << "<path d=";
+	writer << "\"M" << QPointF((x1 + x2) / 2, y1);
+	writer << 'L' << QPointF(x2, y1 + (y2 - y1) * 7 / 18);
+	writer << 'L' << QPointF(x1 + (x2 - x1) * 15.4 / 19, y2);
+	writer << 'L' << QPointF(x1 + (x2 - x1) * 3.6 / 19, y2);
+	writer << 'L' << QPointF(x1, y1 + (y2 - y1) * 7 / 18) << "Z\" ";
+	writeSvgPenAndBrush(writer);
+	writer << "/>";
 }
 
 Hexagon::Hexagon(const QPointF& pos) : Element(Type::Hexagon, pos)
@@ -414,22 +533,21 @@ void Hexagon::updatePath()
 	m_path.lineTo(x1, (y1 + y2) / 2);
 	m_path.closeSubpath();
 }
-std::string Hexagon::toSvgElement() const
+void Hexagon::writeSvgElement(SvgWriter& writer) const
 {
-	std::string hexagon = "<path d=";
 	double x1 = m_boundingRect.topLeft().x();
 	double y1 = m_boundingRect.topLeft().y();
 	double x2 = m_boundingRect.bottomRight().x();
 	double y2 = m_boundingRect.bottomRight().y();
-	hexagon += ("\"M" + std::to_string(x1 + (x2 - x1) / 4) + "," + std::to_string(y1));
-	hexagon += ("L" + std::to_string(x1 + 3 * (x2 - x1) / 4) + "," + std::to_string(y1));
-	hexagon += ("L" + std::to_string(x2) + "," + std::to_string((y1 + y2) / 2));
-	hexagon += ("L" + std::to_string(x1 + 3 * (x2 - x1) / 4) + "," + std::to_string(y2));
-	hexagon += ("L" + std::to_string(x1 + (x2 - x1) / 4) + "," + std::to_string(y2));
-	hexagon += ("L" + std::to_string(x1) + "," + std::to_string((y1 + y2) / 2) + "Z\" ");
-	hexagon += toSvgPenAndBrushAttribute();
-	hexagon += "/>";
-	return hexagon;
+	writer << "<path d=";
+	writer << "\"M" << QPointF(x1 + (x2 - x1) / 4, y1);
+	writer << 'L' << QPointF(x1 + 3 * (x2 - x1) / 4, y1);
+	writer << 'L' << QPointF(x2, (y1 + y2) / 2);
+	writer << 'L' << QPointF(x1 + 3 * (x2 - x1) / 4, y2);
+	writer << 'L' << QPointF(x1 + (x2 - x1) / 4, y2);
+	writer << 'L' << QPointF(x1, (y1 + y2) / 2) << "Z\" ";
+	writeSvgPenAndBrush(writer);
+	writer << "/>";
 }
 
 Star::Star(const QPointF& pos) : Element(Type::Star, pos)
@@ -458,24 +576,23 @@ void Star::updatePath()
 	m_path.lineTo(x1 + (x2 - x1) * 7.3 / 19, y1 + (y2 - y1) * 7 / 18);
 	m_path.closeSubpath();
 }
-std::string Star::toSvgElement() const
+void Star::writeSvgElement(SvgWriter& writer) const
 {
-	std::string star = "<path d=";
 	double x1 = m_boundingRect.topLeft().x();
 	double y1 = m_boundingRect.topLeft().y();
 	double x2 = m_boundingRect.bottomRight().x();
 	double y2 = m_boundingRect.bottomRight().y();
-	star += ("\"M" + std::to_string((x1 + x2) / 2) + "," + std::to_string(y1));
-	star += ("L" + std::to_string(x1 + (x2 - x1) * 11.7 / 19) + "," + std::to_string(y1 + (y2 - y1) * 7 / 18));
-	star += ("L" + std::to_string(x2) + "," + std::to_string(y1 + (y2 - y1) * 7 / 18));
-	star += ("L" + std::to_string(x1 + (x2 - x1) * 13.1 / 19) + "," + std::to_string(y1 + (y2 - y1) * 11.2 / 18));
-	star += ("L" + std::to_string(x1 + (x2 - x1) * 15.4 / 19) + "," + std::to_string(y2));
-	star += ("L" + std::to_string((x1 + x2) / 2) + "," + std::to_string(y1 + (y2 - y1) * 13 / 18));
-	star += ("L" + std::to_string(x1 + (x2 - x1) * 3.6 / 19) + "," + std::to_string(y2));
-	star += ("L" + std::to_string(x1 + (x2 - x1) * 5.9 / 19) + "," + std::to_string(y1 + (y2 - y1) * 11.2 / 18));
-	star += ("L" + std::to_string(x1) + "," + std::to_string(y1 + (y2 - y1) * 7 / 18));
-	star += ("L" + std::to_string(x1 + (x2 - x1) * 7.3 / 19) + "," + std::to_string(y1 + (y2 - y1) * 7 / 18) + "Z\" ");
-	star += toSvgPenAndBrushAttribute();
-	star += "/>";
-	return star;
+	writer << "<path d=";
+	writer << "\"M" << QPointF((x1 + x2) / 2, y1);
+	writer << 'L' << QPointF(x1 + (x2 - x1) * 11.7 / 19, y1 + (y2 - y1) * 7 / 18);
+	writer << 'L' << QPointF(x2, y1 + (y2 - y1) * 7 / 18);
+	writer << 'L' << QPointF(x1 + (x2 - x1) * 13.1 / 19, y1 + (y2 - y1) * 11.2 / 18);
+	writer << 'L' << QPointF(x1 + (x2 - x1) * 15.4 / 19, y2);
+	writer << 'L' << QPointF((x1 + x2) / 2, y1 + (y2 - y1) * 13 / 18);
+	writer << 'L' << QPointF(x1 + (x2 - x1) * 3.6 / 19, y2);
+	writer << 'L' << QPointF(x1 + (x2 - x1) * 5.9 / 19, y1 + (y2 - y1) * 11.2 / 18);
+	writer << 'L' << QPointF(x1, y1 + (y2 - y1) * 7 / 18);
+	writer << 'L' << QPointF(x1 + (x2 - x1) * 7.3 / 19, y1 + (y2 - y1) * 7 / 18) << "Z\" ";
+	writeSvgPenAndBrush(writer);
+	writer << "/>";
 }
\ No newline at end of file
@@ -10,7 +10,13 @@
 #include <QPen>
 #include <QBrush>
 
+#include "strokefilter.h"
+#include "svgwriter.h"
+
 enum class Type { None, Path, Line, Rect, Ellipse, Pentagon, Hexagon, Star };
+// Assigned by Manager when an element enters a document and never reused there; 0 means none.
+using ElementId = quint64;
+
 enum class Edge { NoEdge, LeftEdge, TopLeft, TopEdge, TopRight, RightEdge, BottomRight, BottomEdge, BottomLeft };
 
 class ElementBase
@@ -51,17 +57,22 @@ public:
 	Element& operator=(Element&&) = default;
 	~Element() = default;
 	virtual void updatePath() = 0;
-	virtual std::string toSvgElement() const = 0;
-	std::string toSvgPenAndBrushAttribute() const;
-	void setSelected(bool selected);
-	bool isSelected() const;
+	virtual void writeSvgElement(SvgWriter& writer) const = 0;
+	void writeSvgPenAndBrush(SvgWriter& writer) const;
+	ElementId getId() const;
+	void setId(ElementId id);
+	void clearEdge();
 	bool isPosIn(const QPointF& point) const;
+	QRectF getDirtyRect() const;
+	virtual const QPainterPath& getLodPath(double scale) const;
+	virtual size_t getMemoryUsage() const;
 	Edge recognizeMousePos(const QPointF& pos);
 	virtual void drawShape(const QPointF& pos);
+	virtual bool finishShape();
 	virtual void changeShape(Edge edge, const QPointF& pos);
 	virtual void translate(const QPointF& start, const QPointF& end);
 protected:
-	bool m_selected;
+	ElementId m_id;
 	Edge m_edge;
 };
 
@@ -70,6 +81,7 @@ class Path :public Element
 public:
 	Path() = default;
 	explicit Path(const QPointF& pos);
+	Path(const QPointF& pos, const StrokeFilter& filter);
 	Path(const ElementBase& element);
 	Path(const Path&) = default;
 	Path(Path&&) = default;
@@ -77,13 +89,19 @@ public:
 	Path& operator=(Path&&) = default;
 	~Path() = default;
 	virtual void drawShape(const QPointF& pos) override;
+	virtual bool finishShape() override;
 	virtual void changeShape(Edge edge, const QPointF& pos) override;
 	virtual void updatePath() override;
 	virtual void translate(const QPointF& start, const QPointF& end) override;
+	virtual const QPainterPath& getLodPath(double scale) const override;
+	virtual size_t getMemoryUsage() const override;
 	const std::vector<QPointF>& getPoints() const;
-	virtual std::string toSvgElement() const override;
+	virtual void writeSvgElement(SvgWriter& writer) const override;
 private:
+	bool capturePoint(Capture capture, const QPointF& point);
 	std::vector<QPointF> m_points;
+	StrokeFilter m_filter;
+	mutable std::vector<QPainterPath> m_lods;
 };
 
 class Line :public Element
@@ -98,7 +116,7 @@ public:
 	Line& operator=(Line&&) = default;
 	~Line() = default;
 	virtual void updatePath() override;
-	virtual std::string toSvgElement() const override;
+	virtual void writeSvgElement(SvgWriter& writer) const override;
 };
 
 class Rect :public Element
@@ -113,7 +131,7 @@ public:
 	Rect& operator=(Rect&&) = default;
 	~Rect() = default;
 	virtual void updatePath() override;
-	virtual std::string toSvgElement() const override;
+	virtual void writeSvgElement(SvgWriter& writer) const override;
 };
 
 class Ellipse :public Element
@@ -128,7 +146,7 @@ public:
 	Ellipse& operator=(Ellipse&&) = default;
 	~Ellipse() = default;
 	virtual void updatePath() override;
-	virtual std::string toSvgElement() const override;
+	virtual void writeSvgElement(SvgWriter& writer) const override;
 };
 
 class Pentagon :public Element
@@ -143,7 +161,7 @@ public:
 	Pentagon& operator=(Pentagon&&) = default;
 	~Pentagon() = default;
 	virtual void updatePath() override;
-	virtual std::string toSvgElement() const override;
+	virtual void writeSvgElement(SvgWriter& writer) const override;
 };
 
 class Hexagon :public Element
@@ -158,7 +176,7 @@ public:
 	Hexagon& operator=(Hexagon&&) = default;
 	~Hexagon() = default;
 	virtual void updatePath() override;
-	virtual std::string toSvgElement() const override;
+	virtual void writeSvgElement(SvgWriter& writer) const override;
 };
 
 class Star :public Element
@@ -173,6 +191,6 @@ public:
 	Star& operator=(Star&&) = default;
 	~Star() = default;
 	virtual void updatePath() override;
-	virtual std::string toSvgElement() const override;
+	virtual void writeSvgElement(SvgWriter& writer) const override;
 };
 #endif // !ELEMENT_H_
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "elementstore.h"
+
+#include <algorithm>
+#include <limits>
+
+void ElementStore::update(size_t slot, const Element& item)
+{
+	if (slot >= m_flags.size())
+	{
+		m_types.resize(slot + 1, Type::None);
+		m_left.resize(slot + 1);
+		m_top.resize(slot + 1);
+		m_right.resize(slot + 1);
+		m_bottom.resize(slot + 1);
+		m_styles.resize(slot + 1, NoStyle);
+		m_flags.resize(slot + 1, 0);
+	}
+	QRectF rect = item.getBoungdingRect().normalized();
+	m_types.at(slot) = item.getType();
+	m_left.at(slot) = rect.left();
+	m_top.at(slot) = rect.top();
+	m_right.at(slot) = rect.right();
+	m_bottom.at(slot) = rect.bottom();
+	// Most refreshes only move or reshape the element, so the style lookup is skipped when it is unchanged.
+	quint32& current = m_styles.at(slot);
+	if (current == NoStyle || m_styleTable.at(current).pen != item.getPen() || m_styleTable.at(current).brush != item.getBrush())
+	{
+		quint32 style = acquireStyle(item.getPen(), item.getBrush());
+		releaseStyle(current);
+		current = style;
+	}
+	m_flags.at(slot) |= Live;
+}
+void ElementStore::setLive(size_t slot, bool live)
+{
+	if (live)
+		m_flags.at(slot) |= Live;
+	else
+		m_flags.at(slot) &= ~Live;
+}
+void ElementStore::swap(size_t slot1, size_t slot2)
+{
+	std::swap(m_types.at(slot1), m_types.at(slot2));
+	std::swap(m_left.at(slot1), m_left.at(slot2));
+	std::swap(m_top.at(slot1), m_top.at(slot2));
+	std::swap(m_right.at(slot1), m_right.at(slot2));
+	std::swap(m_bottom.at(slot1), m_bottom.at(slot2));
+	std::swap(m_styles.at(slot1), m_styles.at(slot2));
+	std::swap(m_flags.at(slot1), m_flags.at(slot2));
+}
+// Moves every kept slot i down to map[i]; the map must preserve order, as Manager::compact builds it.
+void ElementStore::remap(const std::vector<size_t>& map, size_t size)
+{
+	for (size_t i = 0; i < m_flags.size(); ++i)
+	{
+		size_t target = map.at(i);
+		if (target >= size)
+			releaseStyle(m_styles.at(i));
+		if (target == i || target >= size)
+			continue;
+		m_types.at(target) = m_types.at(i);
+		m_left.at(target) = m_left.at(i);
+		m_top.at(target) = m_top.at(i);
+		m_right.at(target) = m_right.at(i);
+		m_bottom.at(target) = m_bottom.at(i);
+		m_styles.at(target) = m_styles.at(i);
+		m_flags.at(target) = m_flags.at(i);
+	}
+	m_types.resize(size);
+	m_left.resize(size);
+	m_top.resize(size);
+	m_right.resize(size);
+	m_bottom.resize(size);
+	m_styles.resize(size);
+	m_flags.resize(size);
+}
+size_t ElementStore::getSize() const
+{
+	return m_flags.size();
+}
+bool ElementStore::isLive(size_t slot) const
+{
+	return (m_flags.at(slot) & Live) != 0;
+}
+Type ElementStore::getType(size_t slot) const
+{
+	return m_types.at(slot);
+}
+QRectF ElementStore::getBounds(size_t slot) const
+{
+	return QRectF(QPointF(m_left.at(slot), m_top.at(slot)), QPointF(m_right.at(slot), m_bottom.at(slot)));
+}
+quint32 ElementStore::getStyle(size_t slot) const
+{
+	return m_styles.at(slot);
+}
+// Styles in use, not counting released entries waiting for reuse.
+size_t ElementStore::getStyleCount() const
+{
+	return m_styleTable.size() - m_freeStyles.size();
+}
+const QPen& ElementStore::getPen(quint32 style) const
+{
+	return m_styleTable.at(style).pen;
+}
+const QBrush& ElementStore::getBrush(quint32 style) const
+{
+	return m_styleTable.at(style).brush;
+}
+// Overlap with a non-empty rect. Unlike QRectF::intersects, a horizontal or vertical line, whose
+// bounds have no width or height, still counts.
+bool ElementStore::intersects(size_t slot, const QRectF& rect) const
+{
+	QRectF area = rect.normalized();
+	if (area.width() <= 0 || area.height() <= 0)
+		return false;
+	return m_left.at(slot) < area.right() && area.left() < m_right.at(slot)
+		&& m_top.at(slot) < area.bottom() && area.top() < m_bottom.at(slot);
+}
+// Whether the element, stroke included, covers less than a device pixel each way at this scale.
+bool ElementStore::isBelowPixel(size_t slot, double scale) const
+{
+	double extent = m_styleWidths.at(m_styles.at(slot));
+	return (m_right.at(slot) - m_left.at(slot) + extent) * scale < 1 && (m_bottom.at(slot) - m_top.at(slot) + extent) * scale < 1;
+}
+// Drops the slots whose bounds, grown by the stroke and a margin as Element::getDirtyRect does, miss rect.
+void ElementStore::cull(std::vector<size_t>& indexes, const QRectF& rect) const
+{
+	QRectF area = rect.normalized();
+	const double* left = m_left.data();
+	const double* top = m_top.data();
+	const double* right = m_right.data();
+	const double* bottom = m_bottom.data();
+	const quint32* styles = m_styles.data();
+	const double* widths = m_styleWidths.data();
+	indexes.erase(std::remove_if(indexes.begin(), indexes.end(), [&](size_t i)
+		{
+			double margin = widths[styles[i]] + 2;
+			return !(left[i] - margin < area.right() && area.left() < right[i] + margin
+				&& top[i] - margin < area.bottom() && area.top() < bottom[i] + margin);
+		}), indexes.end());
+}
+std::vector<size_t> ElementStore::getLiveSlots() const
+{
+	std::vector<size_t> indexes;
+	const quint8* flags = m_flags.data();
+	for (size_t i = 0; i < m_flags.size(); ++i)
+	{
+		if ((flags[i] & Live) != 0)
+			indexes.push_back(i);
+	}
+	return indexes;
+}
+// Live slots in [first, last).
+size_t ElementStore::getLiveCount(size_t first, size_t last) const
+{
+	last = qMin(last, m_flags.size());
+	if (first >= last)
+		return 0;
+	return std::count_if(m_flags.begin() + first, m_flags.begin() + last, [](quint8 flags)
+		{
+			return (flags & Live) != 0;
+		});
+}
+// Union of the live bounds, branch free so the loop vectorizes.
+QRectF ElementStore::getBoundingRect() const
+{
+	const double infinity = std::numeric_limits<double>::infinity();
+	double minX = infinity;
+	double minY = infinity;
+	double maxX = -infinity;
+	double maxY = -infinity;
+	const double* left = m_left.data();
+	const double* top = m_top.data();
+	const double* right = m_right.data();
+	const double* bottom = m_bottom.data();
+	const quint8* flags = m_flags.data();
+	for (size_t i = 0; i < m_flags.size(); ++i)
+	{
+		bool live = (flags[i] & Live) != 0;
+		minX = qMin(minX, live ? left[i] : infinity);
+		minY = qMin(minY, live ? top[i] : infinity);
+		maxX = qMax(maxX, live ? right[i] : -infinity);
+		maxY = qMax(maxY, live ? bottom[i] : -infinity);
+	}
+	if (minX > maxX)
+		return QRectF();
+	return QRectF(QPointF(minX, minY), QPointF(maxX, maxY));
+}
+ElementStore::StyleKey ElementStore::getStyleKey(const QPen& pen, const QBrush& brush)
+{
+	return std::make_tuple(pen.color().rgba(), pen.widthF(), static_cast<int>(pen.style()), brush.color().rgba());
+}
+quint32 ElementStore::acquireStyle(const QPen& pen, const QBrush& brush)
+{
+	std::vector<quint32>& bucket = m_styleLookup[getStyleKey(pen, brush)];
+	auto iter = std::find_if(bucket.begin(), bucket.end(), [this, &pen, &brush](quint32 style)
+		{
+			return m_styleTable.at(style).pen == pen && m_styleTable.at(style).brush == brush;
+		});
+	if (iter != bucket.end())
+	{
+		++m_styleCounts.at(*iter);
+		return *iter;
+	}
+	quint32 style = static_cast<quint32>(m_styleTable.size());
+	if (m_freeStyles.empty())
+	{
+		m_styleTable.push_back(Style{ pen, brush });
+		m_styleWidths.push_back(pen.widthF());
+		m_styleCounts.push_back(1);
+	}
+	else
+	{
+		style = m_freeStyles.back();
+		m_freeStyles.pop_back();
+		m_styleTable.at(style) = Style{ pen, brush };
+		m_styleWidths.at(style) = pen.widthF();
+		m_styleCounts.at(style) = 1;
+	}
+	bucket.push_back(style);
+	return style;
+}
+// Dragging a pen width or color through its values creates a style per step; the ones left behind
+// are dropped from the lookup and their entries reused.
+void ElementStore::releaseStyle(quint32 style)
+{
+	if (style == NoStyle || --m_styleCounts.at(style) != 0)
+		return;
+	Style& entry = m_styleTable.at(style);
+	auto lookup = m_styleLookup.find(getStyleKey(entry.pen, entry.brush));
+	std::vector<quint32>& bucket = lookup->second;
+	bucket.erase(std::remove(bucket.begin(), bucket.end(), style), bucket.end());
+	if (bucket.empty())
+		m_styleLookup.erase(lookup);
+	entry = Style();
+	m_freeStyles.push_back(style);
+}
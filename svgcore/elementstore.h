@@ -0,0 +1,73 @@
+#ifndef ELEMENTSTORE_H_
+#define ELEMENTSTORE_H_
+
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include <QBrush>
+#include <QColor>
+#include <QPen>
+#include <QRectF>
+
+#include "element.h"
+
+// The per-slot data of Manager::m_items that culling, selection and bounds queries read, kept in
+// contiguous arrays so those passes sweep memory instead of chasing one heap object per element.
+// Pens and brushes are shared through a reference counted style table and referred to by index; a
+// style no slot uses any more is released for reuse. The elements stay the owners of their geometry;
+// Manager refreshes a slot here whenever it changes one.
+class ElementStore
+{
+public:
+	static constexpr quint32 NoStyle = 0xffffffff;
+	ElementStore() = default;
+	ElementStore(const ElementStore&) = default;
+	ElementStore(ElementStore&&) = default;
+	ElementStore& operator=(const ElementStore&) = default;
+	ElementStore& operator=(ElementStore&&) = default;
+	~ElementStore() = default;
+	void update(size_t slot, const Element& item);
+	void setLive(size_t slot, bool live);
+	void swap(size_t slot1, size_t slot2);
+	void remap(const std::vector<size_t>& map, size_t size);
+	size_t getSize() const;
+	bool isLive(size_t slot) const;
+	Type getType(size_t slot) const;
+	QRectF getBounds(size_t slot) const;
+	quint32 getStyle(size_t slot) const;
+	size_t getStyleCount() const;
+	const QPen& getPen(quint32 style) const;
+	const QBrush& getBrush(quint32 style) const;
+	bool intersects(size_t slot, const QRectF& rect) const;
+	bool isBelowPixel(size_t slot, double scale) const;
+	void cull(std::vector<size_t>& indexes, const QRectF& rect) const;
+	std::vector<size_t> getLiveSlots() const;
+	size_t getLiveCount(size_t first, size_t last) const;
+	QRectF getBoundingRect() const;
+private:
+	enum Flag : quint8 { Live = 0x1 };
+	struct Style
+	{
+		QPen pen;
+		QBrush brush;
+	};
+	typedef std::tuple<QRgb, double, int, QRgb> StyleKey;
+	static StyleKey getStyleKey(const QPen& pen, const QBrush& brush);
+	quint32 acquireStyle(const QPen& pen, const QBrush& brush);
+	void releaseStyle(quint32 style);
+	std::vector<Type> m_types;
+	std::vector<double> m_left;
+	std::vector<double> m_top;
+	std::vector<double> m_right;
+	std::vector<double> m_bottom;
+	std::vector<quint32> m_styles;
+	std::vector<quint8> m_flags;
+	std::vector<Style> m_styleTable;
+	std::vector<double> m_styleWidths;
+	std::vector<quint32> m_styleCounts;
+	std::vector<quint32> m_freeStyles;
+	std::map<StyleKey, std::vector<quint32>> m_styleLookup;
+};
+
+#endif // !ELEMENTSTORE_H_
@@ -0,0 +1,212 @@
+#include "gzipdevice.h"
+
+#include <QMutexLocker>
+#include <QtZlib/zlib.h>
+
+#include "task.h"
+
+namespace
+{
+	const size_t MaxQueuedBlocks = 8;
+	const int BufferSize = 256 << 10;
+	const int GzipWindowBits = MAX_WBITS + 16;
+	const int AutoWindowBits = MAX_WBITS + 32;
+}
+
+GzipWriter::GzipWriter(QIODevice* target, int level)
+	: m_target(target), m_level(level), m_isFinished(false), m_hasError(false)
+{
+	m_pool.setMaxThreadCount(1);
+}
+GzipWriter::~GzipWriter()
+{
+	close();
+}
+bool GzipWriter::open(OpenMode mode)
+{
+	if ((mode & ReadOnly) || !(mode & WriteOnly) || !m_target->isWritable())
+		return false;
+	m_isFinished = false;
+	m_hasError = false;
+	m_pool.start(new Task([this]
+		{
+			compress();
+		}));
+	return QIODevice::open(mode | Unbuffered);
+}
+void GzipWriter::close()
+{
+	if (!isOpen())
+		return;
+	{
+		QMutexLocker locker(&m_mutex);
+		m_isFinished = true;
+		m_changed.wakeAll();
+	}
+	m_pool.waitForDone();
+	if (m_hasError)
+		setErrorString(m_target->errorString());
+	QIODevice::close();
+}
+bool GzipWriter::isSequential() const
+{
+	return true;
+}
+bool GzipWriter::hasError() const
+{
+	return m_hasError;
+}
+qint64 GzipWriter::readData(char*, qint64)
+{
+	return -1;
+}
+qint64 GzipWriter::writeData(const char* data, qint64 size)
+{
+	QMutexLocker locker(&m_mutex);
+	while (!m_hasError && m_blocks.size() >= MaxQueuedBlocks)
+		m_changed.wait(&m_mutex);
+	if (m_hasError)
+		return -1;
+	m_blocks.push_back(QByteArray(data, static_cast<int>(size)));
+	m_changed.wakeAll();
+	return size;
+}
+void GzipWriter::compress()
+{
+	z_stream stream = z_stream();
+	if (deflateInit2(&stream, m_level, Z_DEFLATED, GzipWindowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		QMutexLocker locker(&m_mutex);
+		m_hasError = true;
+		m_changed.wakeAll();
+		return;
+	}
+	QByteArray output(BufferSize, Qt::Uninitialized);
+	bool isLast = false;
+	bool ok = true;
+	while (ok && !isLast)
+	{
+		QByteArray block;
+		{
+			QMutexLocker locker(&m_mutex);
+			while (m_blocks.empty() && !m_isFinished)
+				m_changed.wait(&m_mutex);
+			if (m_blocks.empty())
+			{
+				isLast = true;
+			}
+			else
+			{
+				block = std::move(m_blocks.front());
+				m_blocks.pop_front();
+				m_changed.wakeAll();
+			}
+		}
+		stream.next_in = reinterpret_cast<Bytef*>(block.data());
+		stream.avail_in = block.size();
+		do
+		{
+			stream.next_out = reinterpret_cast<Bytef*>(output.data());
+			stream.avail_out = output.size();
+			deflate(&stream, isLast ? Z_FINISH : Z_NO_FLUSH);
+			qint64 length = output.size() - stream.avail_out;
+			ok = length == 0 || m_target->write(output.constData(), length) == length;
+		} while (ok && stream.avail_out == 0);
+	}
+	deflateEnd(&stream);
+	QMutexLocker locker(&m_mutex);
+	m_hasError = !ok;
+	m_blocks.clear();
+	m_changed.wakeAll();
+}
+
+struct GzipReader::Stream
+{
+	z_stream stream;
+};
+
+GzipReader::GzipReader(QIODevice* source)
+	: m_source(source), m_isAtEnd(false), m_hasError(false)
+{
+}
+GzipReader::~GzipReader()
+{
+	close();
+}
+bool GzipReader::open(OpenMode mode)
+{
+	if ((mode & WriteOnly) || !(mode & ReadOnly) || !m_source->isReadable())
+		return false;
+	m_stream.reset(new Stream());
+	if (inflateInit2(&m_stream->stream, AutoWindowBits) != Z_OK)
+	{
+		m_stream.reset();
+		return false;
+	}
+	m_input.resize(BufferSize);
+	m_isAtEnd = false;
+	m_hasError = false;
+	return QIODevice::open(mode);
+}
+void GzipReader::close()
+{
+	if (m_stream != nullptr)
+	{
+		inflateEnd(&m_stream->stream);
+		m_stream.reset();
+	}
+	QIODevice::close();
+}
+bool GzipReader::isSequential() const
+{
+	return true;
+}
+bool GzipReader::atEnd() const
+{
+	return m_isAtEnd && QIODevice::atEnd();
+}
+bool GzipReader::hasError() const
+{
+	return m_hasError;
+}
+qint64 GzipReader::readData(char* data, qint64 maxSize)
+{
+	z_stream& stream = m_stream->stream;
+	stream.next_out = reinterpret_cast<Bytef*>(data);
+	stream.avail_out = static_cast<uInt>(qMin<qint64>(maxSize, BufferSize));
+	uInt capacity = stream.avail_out;
+	while (!m_isAtEnd && !m_hasError && stream.avail_out == capacity)
+	{
+		if (stream.avail_in == 0)
+		{
+			qint64 length = m_source->read(m_input.data(), m_input.size());
+			if (length <= 0)
+			{
+				m_hasError = true;
+				setErrorString(length < 0 ? m_source->errorString() : "unexpected end of compressed data");
+				break;
+			}
+			stream.next_in = reinterpret_cast<Bytef*>(m_input.data());
+			stream.avail_in = static_cast<uInt>(length);
+		}
+		int result = inflate(&stream, Z_NO_FLUSH);
+		if (result == Z_STREAM_END)
+		{
+			if (stream.avail_in == 0 && m_source->atEnd())
+				m_isAtEnd = true;
+			else
+				inflateReset(&stream);
+		}
+		else if (result != Z_OK && result != Z_BUF_ERROR)
+		{
+			m_hasError = true;
+			setErrorString(stream.msg != nullptr ? stream.msg : "invalid compressed data");
+		}
+	}
+	qint64 length = capacity - stream.avail_out;
+	return length == 0 && m_hasError ? -1 : length;
+}
+qint64 GzipReader::writeData(const char*, qint64)
+{
+	return -1;
+}
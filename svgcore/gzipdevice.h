@@ -0,0 +1,66 @@
+#ifndef GZIPDEVICE_H_
+#define GZIPDEVICE_H_
+
+#include <deque>
+#include <memory>
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QMutex>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+// Write-only device that gzip-compresses into another device. Written data is queued and deflated
+// on a separate thread, so the producer does not wait for compression; the queue is bounded.
+class GzipWriter :public QIODevice
+{
+public:
+	explicit GzipWriter(QIODevice* target, int level = -1);
+	GzipWriter(const GzipWriter&) = delete;
+	GzipWriter& operator=(const GzipWriter&) = delete;
+	~GzipWriter();
+	virtual bool open(OpenMode mode) override;
+	virtual void close() override;
+	virtual bool isSequential() const override;
+	bool hasError() const;
+protected:
+	virtual qint64 readData(char* data, qint64 maxSize) override;
+	virtual qint64 writeData(const char* data, qint64 size) override;
+private:
+	void compress();
+	QIODevice* m_target;
+	int m_level;
+	QThreadPool m_pool;
+	QMutex m_mutex;
+	QWaitCondition m_changed;
+	std::deque<QByteArray> m_blocks;
+	bool m_isFinished;
+	bool m_hasError;
+};
+
+// Read-only device that inflates a gzip (or zlib) stream from another device on demand.
+class GzipReader :public QIODevice
+{
+public:
+	explicit GzipReader(QIODevice* source);
+	GzipReader(const GzipReader&) = delete;
+	GzipReader& operator=(const GzipReader&) = delete;
+	~GzipReader();
+	virtual bool open(OpenMode mode) override;
+	virtual void close() override;
+	virtual bool isSequential() const override;
+	virtual bool atEnd() const override;
+	bool hasError() const;
+protected:
+	virtual qint64 readData(char* data, qint64 maxSize) override;
+	virtual qint64 writeData(const char* data, qint64 size) override;
+private:
+	struct Stream;
+	QIODevice* m_source;
+	std::unique_ptr<Stream> m_stream;
+	QByteArray m_input;
+	bool m_isAtEnd;
+	bool m_hasError;
+};
+
+#endif // !GZIPDEVICE_H_
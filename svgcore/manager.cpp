@@ -0,0 +1,822 @@
+#include "manager.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+#include <QElapsedTimer>
+
+#include "command.h"
+#include "tracer.h"
+
+namespace
+{
+	const size_t MinTombstones = 256;
+	const double CompactRatio = 0.5;
+	const size_t MaxDamageRects = 32;
+
+	// Covers a minus b, both normalized, with up to four rects.
+	std::vector<QRectF> subtract(const QRectF& a, const QRectF& b)
+	{
+		if (a.isEmpty())
+			return {};
+		if (!a.intersects(b))
+			return { a };
+		std::vector<QRectF> pieces;
+		if (b.top() > a.top())
+			pieces.emplace_back(QPointF(a.left(), a.top()), QPointF(a.right(), b.top()));
+		if (b.bottom() < a.bottom())
+			pieces.emplace_back(QPointF(a.left(), b.bottom()), QPointF(a.right(), a.bottom()));
+		double top = qMax(a.top(), b.top());
+		double bottom = qMin(a.bottom(), b.bottom());
+		if (b.left() > a.left())
+			pieces.emplace_back(QPointF(a.left(), top), QPointF(b.left(), bottom));
+		if (b.right() < a.right())
+			pieces.emplace_back(QPointF(b.right(), top), QPointF(a.right(), bottom));
+		return pieces;
+	}
+}
+
+Manager::Manager()
+	: m_nextId(1)
+	, m_selectedItem(nullptr)
+	, m_singleBoard(nullptr)
+	, m_history(CommandHistory::getInstance())
+	, m_maxPenWidth(1)
+	, m_isLiveEditing(false)
+	, m_liveFirst(0)
+	, m_liveLast(0)
+	, m_pinnedTombstones(0)
+	, m_trimCount(m_history.getTrimCount())
+{
+}
+// The history is shared by every document, so commands of this one must not outlive it: another
+// Manager may later be created at the same address and would be mistaken for it.
+Manager::~Manager()
+{
+	m_history.removeCommands(this);
+}
+std::shared_ptr<Element> Manager::clone(std::shared_ptr<Element> item)
+{
+	switch (item->getType())
+	{
+	case Type::Path:
+		return std::make_shared<Path>(*item);
+		break;
+	case Type::Line:
+		return std::make_shared<Line>(*item);
+		break;
+	case Type::Rect:
+		return std::make_shared<Rect>(*item);
+		break;
+	case Type::Ellipse:
+		return std::make_shared<Ellipse>(*item);
+		break;
+	case Type::Pentagon:
+		return std::make_shared<Pentagon>(*item);
+		break;
+	case Type::Hexagon:
+		return std::make_shared<Hexagon>(*item);
+		break;
+	case Type::Star:
+		return std::make_shared<Star>(*item);
+		break;
+	default:
+		return nullptr;
+		break;
+	}
+}
+void Manager::copy(const QPointF& pos)
+{
+	m_singleBoard = nullptr;
+	m_clipBoard.clear();
+	m_copyStartPos = pos;
+	if (m_selectedItem != nullptr)
+	{
+		m_singleBoard = clone(m_selectedItem);
+	}
+	else
+	{
+		std::vector<size_t> selected = getSelectedSlots();
+		std::for_each(selected.begin(), selected.end(), [this](size_t i)
+			{
+				m_clipBoard.push_back(clone(m_items.at(i)));
+			});
+	}
+}
+bool Manager::isAnyOneCopied()
+{
+	return m_singleBoard != nullptr || !m_clipBoard.empty();
+}
+void Manager::removeItem()
+{
+	if (m_selectedItem != nullptr)
+	{
+		size_t i = indexOf(m_selectedItem);
+		if (i != m_items.size())
+		{
+			m_history.addCommand(std::make_shared<Remove>(this, m_selectedItem));
+			addDamage(m_selectedItem);
+			detachItem(m_ids.at(i));
+		}
+		m_selectedItem = nullptr;
+	}
+	else
+	{
+		std::vector<std::shared_ptr<Command>> commands;
+		std::vector<size_t> selected = getSelectedSlots();
+		std::for_each(selected.begin(), selected.end(), [this, &commands](size_t i)
+			{
+				commands.push_back(std::make_shared<Remove>(this, m_items.at(i)));
+				addDamage(m_items.at(i));
+				detachItem(m_ids.at(i));
+			});
+		if (!commands.empty())
+			m_history.addCommands(commands);
+	}
+	compactIfNeeded();
+}
+void Manager::paste(const QPointF& pos)
+{
+	if (m_singleBoard != nullptr)
+	{
+		std::shared_ptr<Element> cloneptr = clone(m_singleBoard);
+		cloneptr->translate(m_copyStartPos, pos);
+		appendItem(cloneptr);
+		select(cloneptr);
+		m_history.addCommand(std::make_shared<Add>(this, cloneptr));
+		m_selectedItem = cloneptr;
+	}
+	else
+	{
+		std::vector<std::shared_ptr<Command>> commands;
+		std::for_each(m_clipBoard.begin(), m_clipBoard.end(), [this, &pos, &commands](std::shared_ptr<Element> item)
+			{
+				std::shared_ptr<Element> cloneptr = clone(item);
+				cloneptr->translate(m_copyStartPos, pos);
+				appendItem(cloneptr);
+				select(cloneptr);
+				commands.push_back(std::make_shared<Add>(this, cloneptr));
+			});
+		if (!commands.empty())
+			m_history.addCommands(commands);
+	}
+	compactIfNeeded();
+}
+void Manager::upLayer()
+{
+	if (m_items.size() < 2)
+		return;
+	size_t i = indexOf(m_selectedItem);
+	if (i + 1 < m_items.size())
+	{
+		m_history.addCommand(std::make_shared<SwapLayer>(this, m_ids.at(i), m_ids.at(i + 1)));
+		swapItems(m_ids.at(i), m_ids.at(i + 1));
+		addDamage(m_items.at(i));
+		addDamage(m_items.at(i + 1));
+	}
+	compactIfNeeded();
+}
+void Manager::downLayer()
+{
+	if (m_items.size() < 2)
+		return;
+	size_t i = indexOf(m_selectedItem);
+	if (i != m_items.size() && i > 0)
+	{
+		m_history.addCommand(std::make_shared<SwapLayer>(this, m_ids.at(i), m_ids.at(i - 1)));
+		swapItems(m_ids.at(i), m_ids.at(i - 1));
+		addDamage(m_items.at(i));
+		addDamage(m_items.at(i - 1));
+	}
+	compactIfNeeded();
+}
+void Manager::upMost()
+{
+	size_t i = indexOf(m_selectedItem);
+	if (i == m_items.size())
+		return;
+	m_history.addCommand(std::make_shared<SwapLayer>(this, m_ids.at(i), m_ids.back()));
+	swapItems(m_ids.at(i), m_ids.back());
+	addDamage(m_items.at(i));
+	addDamage(m_items.back());
+	compactIfNeeded();
+}
+void Manager::downMost()
+{
+	size_t i = indexOf(m_selectedItem);
+	if (i == m_items.size())
+		return;
+	m_history.addCommand(std::make_shared<SwapLayer>(this, m_ids.at(i), m_ids.front()));
+	swapItems(m_ids.at(i), m_ids.front());
+	addDamage(m_items.at(i));
+	addDamage(m_items.front());
+	compactIfNeeded();
+}
+
+void Manager::addItem(Type type, const QPointF& pos)
+{
+	std::shared_ptr<Element> item;
+	switch (type)
+	{
+	case Type::Path:
+		item = std::make_shared<Path>(pos, m_strokeFilter);
+		break;
+	case Type::Line:
+		item = std::make_shared<Line>(pos);
+		break;
+	case Type::Rect:
+		item = std::make_shared<Rect>(pos);
+		break;
+	case Type::Ellipse:
+		item = std::make_shared<Ellipse>(pos);
+		break;
+	case Type::Pentagon:
+		item = std::make_shared<Pentagon>(pos);
+		break;
+	case Type::Hexagon:
+		item = std::make_shared<Hexagon>(pos);
+		break;
+	case Type::Star:
+		item = std::make_shared<Star>(pos);
+		break;
+	default:
+		return;
+	}
+	m_selectedItem = item;
+	appendItem(item);
+	m_history.addCommand(std::make_shared<Add>(this, item));
+	select(item);
+	compactIfNeeded();
+}
+void Manager::createItem(Type type, const QRectF& rect, const QPainterPath& path, const QPen& pen, const QBrush& brush)
+{
+	std::shared_ptr<Element> item;
+	switch (type)
+	{
+	case Type::Path:
+		item = std::make_shared<Path>(ElementBase(type, rect, path, pen, brush));
+		break;
+	case Type::Line:
+		item = std::make_shared<Line>(ElementBase(type, rect, path, pen, brush));
+		break;
+	case Type::Rect:
+		item = std::make_shared<Rect>(ElementBase(type, rect, path, pen, brush));
+		break;
+	case Type::Ellipse:
+		item = std::make_shared<Ellipse>(ElementBase(type, rect, path, pen, brush));
+		break;
+	case Type::Pentagon:
+		item = std::make_shared<Pentagon>(ElementBase(type, rect, path, pen, brush));
+		break;
+	case Type::Hexagon:
+		item = std::make_shared<Hexagon>(ElementBase(type, rect, path, pen, brush));
+		break;
+	case Type::Star:
+		item = std::make_shared<Star>(ElementBase(type, rect, path, pen, brush));
+		break;
+	default:
+		return;
+	}
+	m_maxPenWidth = qMax(m_maxPenWidth, pen.widthF());
+	appendItem(item);
+}
+void Manager::addItems(const std::vector<ElementBase>& items)
+{
+	std::for_each(items.begin(), items.end(), [this](const ElementBase& item)
+		{
+			size_t count = m_items.size();
+			createItem(item.getType(), item.getBoungdingRect(), item.getPath(), item.getPen(), item.getBrush());
+			if (m_items.size() != count)
+				addDamage(m_items.back());
+		});
+}
+void Manager::setSelectedPenWidth(double width)
+{
+	if (m_selectedItem != nullptr)
+	{
+		QPen pen = m_selectedItem->getPen();
+		pen.setWidthF(width);
+		m_history.addCommand(std::make_shared<ChangePen>(this, m_selectedItem, pen));
+		setItemPen(m_selectedItem, pen);
+	}
+	compactIfNeeded();
+}
+void Manager::setSelectedPenColor(const QColor& color)
+{
+	if (m_selectedItem != nullptr)
+	{
+		QPen pen = m_selectedItem->getPen();
+		pen.setColor(color);
+		m_history.addCommand(std::make_shared<ChangePen>(this, m_selectedItem, pen));
+		setItemPen(m_selectedItem, pen);
+	}
+	compactIfNeeded();
+}
+void Manager::setSelectedPenStyle(Qt::PenStyle style)
+{
+	if (m_selectedItem != nullptr)
+	{
+		QPen pen = m_selectedItem->getPen();
+		pen.setStyle(style);
+		m_history.addCommand(std::make_shared<ChangePen>(this, m_selectedItem, pen));
+		setItemPen(m_selectedItem, pen);
+	}
+	compactIfNeeded();
+}
+void Manager::setSelectedBrushColor(const QColor& color)
+{
+	if (m_selectedItem != nullptr)
+	{
+		m_history.addCommand(std::make_shared<ChangeBrush>(this, m_selectedItem, QBrush(color)));
+		setItemBrush(m_selectedItem, QBrush(color));
+	}
+	compactIfNeeded();
+}
+void Manager::setItemPen(const std::shared_ptr<Element>& item, const QPen& pen)
+{
+	addDamage(item);
+	item->setPen(pen);
+	m_maxPenWidth = qMax(m_maxPenWidth, pen.widthF());
+	updateIndex(indexOf(item));
+	addDamage(item);
+}
+void Manager::setItemBrush(const std::shared_ptr<Element>& item, const QBrush& brush)
+{
+	item->setBrush(brush);
+	updateIndex(indexOf(item));
+	addDamage(item);
+}
+void Manager::setCaptureTolerance(double tolerance)
+{
+	m_strokeFilter.setTolerance(tolerance);
+}
+void Manager::setCaptureSmoothing(double smoothing)
+{
+	m_strokeFilter.setSmoothing(smoothing);
+}
+const StrokeFilter& Manager::getStrokeFilter() const
+{
+	return m_strokeFilter;
+}
+void Manager::paint(QPainter* painter, const QRectF& exposed, Layer layer)
+{
+	TRACE_SCOPE("Manager::paint", "paint");
+	QElapsedTimer timer;
+	timer.start();
+	double margin = m_maxPenWidth + 2;
+	std::vector<size_t> indexes = m_index.query(exposed.adjusted(-margin, -margin, margin, margin));
+	std::sort(indexes.begin(), indexes.end());
+	// The elements of the painted layer that neither the index query nor the cull below let through.
+	size_t considered = m_index.getCount();
+	if (m_isLiveEditing && layer != Layer::All)
+	{
+		auto first = std::lower_bound(indexes.begin(), indexes.end(), m_liveFirst);
+		auto last = std::upper_bound(indexes.begin(), indexes.end(), m_liveLast);
+		if (layer == Layer::Below)
+		{
+			indexes.erase(first, indexes.end());
+			considered = m_store.getLiveCount(0, m_liveFirst);
+		}
+		else if (layer == Layer::Live)
+		{
+			indexes = std::vector<size_t>(first, last);
+			considered = m_store.getLiveCount(m_liveFirst, m_liveLast + 1);
+		}
+		else
+		{
+			indexes.erase(indexes.begin(), last);
+			considered = m_store.getLiveCount(m_liveLast + 1, m_store.getSize());
+		}
+	}
+	// Culling, simplification and state changes read the contiguous store; only elements that are
+	// drawn as paths are dereferenced. Pen and brush are set only when the style changes.
+	m_store.cull(indexes, exposed);
+	m_paintStats.culled += considered - qMin(considered, indexes.size());
+	double scale = painter->worldTransform().m11();
+	quint32 current = ElementStore::NoStyle;
+	painter->save();
+	painter->setRenderHint(QPainter::Antialiasing);
+	std::for_each(indexes.begin(), indexes.end(), [this, painter, scale, &current](size_t i)
+		{
+			++m_paintStats.drawn;
+			quint32 style = m_store.getStyle(i);
+			if (m_store.isBelowPixel(i, scale))
+			{
+				++m_paintStats.simplified;
+				painter->setPen(QPen(m_store.getPen(style).color(), 0));
+				painter->drawPoint(m_store.getBounds(i).center());
+				current = ElementStore::NoStyle;
+			}
+			else
+			{
+				if (style != current)
+				{
+					painter->setPen(m_store.getPen(style));
+					painter->setBrush(m_store.getBrush(style));
+					current = style;
+				}
+				painter->drawPath(m_items.at(i)->getLodPath(scale));
+			}
+			if (m_selection.contains(m_ids.at(i)))
+			{
+				painter->setPen(QPen(Qt::blue, 1, Qt::PenStyle::DashLine));
+				painter->setBrush(Qt::transparent);
+				painter->drawRect(m_store.getBounds(i));
+				current = ElementStore::NoStyle;
+			}
+		});
+	painter->restore();
+	m_paintStats.nsecs += timer.nsecsElapsed();
+}
+PaintStats Manager::takePaintStats()
+{
+	PaintStats stats = m_paintStats;
+	m_paintStats = PaintStats();
+	return stats;
+}
+size_t Manager::getLiveCount() const
+{
+	return m_index.getCount();
+}
+QRectF Manager::getBoundingRect() const
+{
+	return m_store.getBoundingRect();
+}
+// Drops the null slots left by removals that no command in the history can restore any more, and
+// renumbers the remaining slots. Returns the number of slots freed.
+size_t Manager::compact()
+{
+	if (m_isLiveEditing)
+		return 0;
+	TRACE_SCOPE("Manager::compact", "edit");
+	std::vector<bool> isKept(m_items.size());
+	for (size_t i = 0; i < m_items.size(); ++i)
+		isKept.at(i) = m_items.at(i) != nullptr;
+	m_history.forEachId(this, [this, &isKept](ElementId id)
+		{
+			isKept.at(m_slots.at(id)) = true;
+		});
+	std::vector<size_t> map(m_items.size(), std::numeric_limits<size_t>::max());
+	size_t count = 0;
+	for (size_t i = 0; i < m_items.size(); ++i)
+	{
+		if (!isKept.at(i))
+		{
+			m_slots.erase(m_ids.at(i));
+			continue;
+		}
+		map.at(i) = count;
+		m_slots.at(m_ids.at(i)) = count;
+		if (count != i)
+		{
+			m_items.at(count) = std::move(m_items.at(i));
+			m_ids.at(count) = m_ids.at(i);
+		}
+		++count;
+	}
+	size_t freed = m_items.size() - count;
+	m_pinnedTombstones = count - m_index.getCount();
+	if (freed == 0)
+		return 0;
+	m_items.resize(count);
+	m_ids.resize(count);
+	m_index.remap(map, count);
+	m_store.remap(map, count);
+	return freed;
+}
+// Tombstones still referenced by the history survive a compaction, so only the ones added since the
+// last run count towards the threshold; otherwise a long history would trigger a futile pass per edit.
+void Manager::compactIfNeeded()
+{
+	// Dropped redo entries may have been the last references to some tombstones, which count as
+	// fresh again until the next compaction finds out which are still pinned.
+	if (m_history.getTrimCount() != m_trimCount)
+	{
+		m_trimCount = m_history.getTrimCount();
+		m_pinnedTombstones = 0;
+	}
+	size_t tombstones = m_items.size() - m_index.getCount();
+	size_t fresh = tombstones - qMin(tombstones, m_pinnedTombstones);
+	if (fresh >= MinTombstones && tombstones > m_items.size() * CompactRatio)
+		compact();
+}
+std::vector<QRectF> Manager::takeDamage()
+{
+	std::vector<QRectF> damage;
+	damage.swap(m_damage);
+	return damage;
+}
+void Manager::beginLiveEdit()
+{
+	m_isLiveEditing = false;
+	if (m_selectedItem != nullptr)
+	{
+		m_liveFirst = indexOf(m_selectedItem);
+		m_liveLast = m_liveFirst;
+		m_isLiveEditing = m_liveFirst != m_items.size();
+		return;
+	}
+	std::vector<size_t> selected = getSelectedSlots();
+	if (!selected.empty())
+	{
+		m_liveFirst = selected.front();
+		m_liveLast = selected.back();
+		m_isLiveEditing = true;
+	}
+}
+void Manager::endLiveEdit()
+{
+	m_isLiveEditing = false;
+	// A smoothed stroke lags the cursor, so its tail is drawn when the stroke ends. Drawing only
+	// grows the item, so the new dirty rect covers the old one.
+	if (m_selectedItem != nullptr && m_selectedItem->finishShape())
+	{
+		addDamage(m_selectedItem);
+		updateIndex(indexOf(m_selectedItem));
+	}
+}
+bool Manager::isLiveEditing() const
+{
+	return m_isLiveEditing;
+}
+bool Manager::isItemAt(const QPointF& pos) const
+{
+	return !itemsAt(pos).empty();
+}
+void Manager::selectItemAt(const QPointF& pos)
+{
+	if (m_selectedItem != nullptr)
+		if (m_selectedItem->isPosIn(pos))
+			return;
+	cancelSelected();
+	std::vector<std::shared_ptr<Element>> items = itemsAt(pos);
+	if (!items.empty())
+	{
+		m_selectedItem = items.back();
+		select(m_selectedItem);
+	}
+}
+std::shared_ptr<Element> Manager::getSelectedItem() const
+{
+	return m_selectedItem;
+}
+const std::vector<std::shared_ptr<Element>>& Manager::getItems() const
+{
+	return m_items;
+}
+std::vector<std::shared_ptr<Element>> Manager::itemsAt(const QPointF& pos) const
+{
+	std::vector<size_t> indexes = m_index.query(pos, 5);
+	std::sort(indexes.begin(), indexes.end());
+	std::vector<std::shared_ptr<Element>> items;
+	std::for_each(indexes.begin(), indexes.end(), [this, &pos, &items](size_t i)
+		{
+			if (m_items.at(i)->isPosIn(pos))
+				items.push_back(m_items.at(i));
+		});
+	return items;
+}
+std::vector<std::shared_ptr<Element>> Manager::itemsIn(const QRectF& rect) const
+{
+	std::vector<size_t> indexes = m_index.query(rect);
+	std::sort(indexes.begin(), indexes.end());
+	std::vector<std::shared_ptr<Element>> items;
+	std::for_each(indexes.begin(), indexes.end(), [this, &rect, &items](size_t i)
+		{
+			if (m_store.intersects(i, rect))
+				items.push_back(m_items.at(i));
+		});
+	return items;
+}
+void Manager::selectItems(const QRectF& rect)
+{
+	cancelSelected();
+	std::vector<std::shared_ptr<Element>> items = itemsIn(rect);
+	std::for_each(items.begin(), items.end(), [this](std::shared_ptr<Element> item)
+		{
+			select(item);
+		});
+}
+// Moves a selection rect: expects the selection to be exactly what intersects from, and only tests the
+// elements near the area that one of the two rects covers and the other does not.
+void Manager::selectItems(const QRectF& from, const QRectF& to)
+{
+	QRectF before = from.normalized();
+	QRectF after = to.normalized();
+	std::vector<QRectF> changed = subtract(before, after);
+	std::vector<QRectF> added = subtract(after, before);
+	changed.insert(changed.end(), added.begin(), added.end());
+	std::vector<size_t> indexes;
+	std::for_each(changed.begin(), changed.end(), [this, &indexes](const QRectF& rect)
+		{
+			std::vector<size_t> found = m_index.query(rect);
+			indexes.insert(indexes.end(), found.begin(), found.end());
+		});
+	std::sort(indexes.begin(), indexes.end());
+	indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+	std::vector<ElementId> leaving;
+	std::for_each(indexes.begin(), indexes.end(), [this, &before, &after, &leaving](size_t i)
+		{
+			std::shared_ptr<Element> item = m_items.at(i);
+			bool wasIn = m_store.intersects(i, before);
+			bool isIn = m_store.intersects(i, after);
+			if (isIn && !wasIn)
+			{
+				select(item);
+			}
+			else if (wasIn && !isIn && m_selection.contains(item->getId()))
+			{
+				leaving.push_back(item->getId());
+				addDamage(item);
+			}
+		});
+	m_selection.erase(leaving);
+}
+void Manager::selectAll()
+{
+	cancelSelected();
+	std::vector<size_t> live = m_store.getLiveSlots();
+	std::for_each(live.begin(), live.end(), [this](size_t i)
+		{
+			select(m_items.at(i));
+		});
+}
+void Manager::cancelSelected()
+{
+	const std::vector<ElementId>& ids = m_selection.getIds();
+	std::for_each(ids.begin(), ids.end(), [this](ElementId id)
+		{
+			addDamage(m_items.at(m_slots.at(id)));
+		});
+	m_selection.clear();
+	if (m_selectedItem != nullptr)
+		m_selectedItem->clearEdge();
+	m_selectedItem = nullptr;
+}
+bool Manager::isOnlyOneSelected() const
+{
+	return m_selectedItem != nullptr;
+}
+bool Manager::isAnyOneSelected() const
+{
+	return !m_selection.isEmpty();
+}
+void Manager::moveItem(const QPointF& start, const QPointF& end)
+{
+	if (m_selectedItem != nullptr)
+	{
+		size_t i = indexOf(m_selectedItem);
+		addDamage(m_selectedItem);
+		m_selectedItem->translate(start, end);
+		addDamage(m_selectedItem);
+		updateIndex(i);
+	}
+	else
+	{
+		const std::vector<ElementId>& ids = m_selection.getIds();
+		std::for_each(ids.begin(), ids.end(), [this, &start, &end](ElementId id)
+			{
+				size_t i = m_slots.at(id);
+				addDamage(m_items.at(i));
+				m_items.at(i)->translate(start, end);
+				addDamage(m_items.at(i));
+				updateIndex(i);
+			});
+	}
+}
+Edge Manager::recognizeMousePos(const QPointF& pos)
+{
+
+	return m_selectedItem != nullptr ? m_selectedItem->recognizeMousePos(pos) : Edge::NoEdge;
+}
+void Manager::drawItemShape(const QPointF& pos)
+{
+	if (m_selectedItem != nullptr)
+	{
+		size_t i = indexOf(m_selectedItem);
+		addDamage(m_selectedItem);
+		m_selectedItem->drawShape(pos);
+		addDamage(m_selectedItem);
+		updateIndex(i);
+	}
+}
+void Manager::changeItemShape(Edge edge, const QPointF& pos)
+{
+	if (m_selectedItem != nullptr)
+	{
+		size_t i = indexOf(m_selectedItem);
+		addDamage(m_selectedItem);
+		m_selectedItem->changeShape(edge, pos);
+		addDamage(m_selectedItem);
+		updateIndex(i);
+	}
+}
+void Manager::writeSvgElements(SvgWriter& writer) const
+{
+	std::for_each(m_items.begin(), m_items.end(), [&writer](std::shared_ptr<Element> iter)
+		{
+			if (iter == nullptr)
+				return;
+			writer << '\t';
+			iter->writeSvgElement(writer);
+			writer << '\n';
+		});
+}
+void Manager::writeSvg(SvgWriter& writer, const QSize& size, const QColor& background) const
+{
+	TRACE_SCOPE("Manager::writeSvg", "io");
+	writer << "<svg width=\"" << size.width() << "\" height=\"" << size.height() << "\" xmlns=\"http://www.w3.org/2000/svg\">\n";
+	if (background != Qt::white)
+		writer << "\t<rect width=\"100%\" height=\"100%\" fill = \"" << background.name() << "\"/>\n";
+	writeSvgElements(writer);
+	writer << "</svg>";
+}
+void Manager::restoreItem(const std::shared_ptr<Element>& item)
+{
+	size_t slot = m_slots.at(item->getId());
+	m_items.at(slot) = item;
+	m_index.insert(slot, item->getBoungdingRect());
+	m_store.update(slot, *item);
+}
+void Manager::detachItem(ElementId id)
+{
+	size_t slot = m_slots.at(id);
+	if (m_items.at(slot) == m_selectedItem)
+		m_selectedItem = nullptr;
+	m_selection.erase(id);
+	m_items.at(slot) = nullptr;
+	m_index.remove(slot);
+	m_store.setLive(slot, false);
+}
+void Manager::swapItems(ElementId id1, ElementId id2)
+{
+	size_t& slot1 = m_slots.at(id1);
+	size_t& slot2 = m_slots.at(id2);
+	m_items.at(slot1).swap(m_items.at(slot2));
+	std::swap(m_ids.at(slot1), m_ids.at(slot2));
+	m_index.swap(slot1, slot2);
+	m_store.swap(slot1, slot2);
+	std::swap(slot1, slot2);
+}
+size_t Manager::appendItem(std::shared_ptr<Element> item)
+{
+	size_t slot = m_items.size();
+	item->setId(m_nextId++);
+	m_slots.emplace(item->getId(), slot);
+	m_ids.push_back(item->getId());
+	m_items.push_back(item);
+	updateIndex(slot);
+	return slot;
+}
+void Manager::select(const std::shared_ptr<Element>& item)
+{
+	if (m_selection.insert(item->getId()))
+		addDamage(item);
+}
+// The selected slots in painting order.
+std::vector<size_t> Manager::getSelectedSlots() const
+{
+	const std::vector<ElementId>& ids = m_selection.getIds();
+	std::vector<size_t> selected(ids.size());
+	std::transform(ids.begin(), ids.end(), selected.begin(), [this](ElementId id)
+		{
+			return m_slots.at(id);
+		});
+	std::sort(selected.begin(), selected.end());
+	return selected;
+}
+size_t Manager::indexOf(const std::shared_ptr<Element>& item) const
+{
+	if (item == nullptr)
+		return m_items.size();
+	auto iter = m_slots.find(item->getId());
+	if (iter == m_slots.end() || m_items.at(iter->second) != item)
+		return m_items.size();
+	return iter->second;
+}
+// Refreshes everything derived from the element in a slot after it changed.
+void Manager::updateIndex(size_t index)
+{
+	if (index < m_items.size() && m_items.at(index) != nullptr)
+	{
+		m_index.update(index, m_items.at(index)->getBoungdingRect());
+		m_store.update(index, *m_items.at(index));
+	}
+}
+void Manager::addDamage(const std::shared_ptr<Element>& item)
+{
+	if (item == nullptr)
+		return;
+	m_damage.push_back(item->getDirtyRect());
+	// Past a few rects the damage is kept as their union. A view repaints no more than that anyway,
+	// and headless users such as svgconvert never take the damage.
+	if (m_damage.size() > MaxDamageRects)
+	{
+		QRectF united = std::accumulate(m_damage.begin() + 1, m_damage.end(), m_damage.front(), [](const QRectF& sum, const QRectF& rect)
+			{
+				return sum.united(rect);
+			});
+		m_damage.assign(1, united);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#ifndef MANAGER_H_
+#define MANAGER_H_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <QColor>
+#include <QPainter>
+#include <QPointF>
+#include <QRectF>
+#include <QSize>
+
+#include "commandhistory.h"
+#include "element.h"
+#include "elementstore.h"
+#include "selectionset.h"
+#include "spatialindex.h"
+#include "svgwriter.h"
+
+enum class Layer { All, Below, Live, Above };
+
+struct PaintStats
+{
+	size_t drawn = 0;
+	size_t culled = 0;
+	size_t simplified = 0;
+	qint64 nsecs = 0;
+};
+
+class Manager
+{
+public:
+	Manager();
+	Manager(const Manager&) = default;
+	Manager(Manager&&) = default;
+	Manager& operator=(const Manager&) = default;
+	Manager& operator=(Manager&&) = default;
+	~Manager();
+
+	std::shared_ptr<Element> clone(std::shared_ptr<Element> item);
+	void copy(const QPointF& pos);
+	bool isAnyOneCopied();
+	void removeItem();
+	void paste(const QPointF& pos);
+	void upLayer();
+	void downLayer();
+	void upMost();
+	void downMost();
+
+	void setSelectedPenWidth(double width);
+	void setSelectedPenColor(const QColor& color);
+	void setSelectedPenStyle(Qt::PenStyle style);
+	void setSelectedBrushColor(const QColor& color);
+	void setCaptureTolerance(double tolerance);
+	void setCaptureSmoothing(double smoothing);
+	const StrokeFilter& getStrokeFilter() const;
+	void setItemPen(const std::shared_ptr<Element>& item, const QPen& pen);
+	void setItemBrush(const std::shared_ptr<Element>& item, const QBrush& brush);
+
+	void addItem(Type type, const QPointF& pos);
+	void createItem(Type type, const QRectF& rect, const QPainterPath& path, const QPen& pen, const QBrush& brush);
+	void addItems(const std::vector<ElementBase>& items);
+	bool isItemAt(const QPointF& pos) const;
+	void selectItemAt(const QPointF& pos);
+	std::shared_ptr<Element> getSelectedItem() const;
+	const std::vector<std::shared_ptr<Element>>& getItems() const;
+	std::vector<std::shared_ptr<Element>> itemsAt(const QPointF& pos) const;
+	std::vector<std::shared_ptr<Element>> itemsIn(const QRectF& rect) const;
+	void selectItems(const QRectF& rect);
+	void selectItems(const QRectF& from, const QRectF& to);
+	void selectAll();
+	void cancelSelected();
+	bool isOnlyOneSelected() const;
+	bool isAnyOneSelected() const;
+	void paint(QPainter* painter, const QRectF& exposed, Layer layer = Layer::All);
+	PaintStats takePaintStats();
+	size_t getLiveCount() const;
+	QRectF getBoundingRect() const;
+	size_t compact();
+	void compactIfNeeded();
+	std::vector<QRectF> takeDamage();
+	void beginLiveEdit();
+	void endLiveEdit();
+	bool isLiveEditing() const;
+	void moveItem(const QPointF& start, const QPointF& end);
+	Edge recognizeMousePos(const QPointF& pos);
+	void drawItemShape(const QPointF& pos);
+	void changeItemShape(Edge edge, const QPointF& pos);
+	void writeSvgElements(SvgWriter& writer) const;
+	void writeSvg(SvgWriter& writer, const QSize& size, const QColor& background) const;
+	void restoreItem(const std::shared_ptr<Element>& item);
+	void detachItem(ElementId id);
+	void swapItems(ElementId id1, ElementId id2);
+private:
+	size_t appendItem(std::shared_ptr<Element> item);
+	void select(const std::shared_ptr<Element>& item);
+	std::vector<size_t> getSelectedSlots() const;
+	size_t indexOf(const std::shared_ptr<Element>& item) const;
+	void updateIndex(size_t index);
+	void addDamage(const std::shared_ptr<Element>& item);
+	std::vector<std::shared_ptr<Element>> m_items;
+	// Slot to ID and back. A removed element keeps its slot, empty, until compaction frees it.
+	std::vector<ElementId> m_ids;
+	std::unordered_map<ElementId, size_t> m_slots;
+	ElementId m_nextId;
+	SpatialIndex m_index;
+	ElementStore m_store;
+	std::shared_ptr<Element> m_selectedItem;
+	SelectionSet m_selection;
+	std::vector<std::shared_ptr<Element>> m_clipBoard;
+	std::shared_ptr<Element> m_singleBoard;
+	CommandHistory& m_history;
+	QPointF m_copyStartPos;
+	std::vector<QRectF> m_damage;
+	double m_maxPenWidth;
+	StrokeFilter m_strokeFilter;
+	bool m_isLiveEditing;
+	size_t m_liveFirst;
+	size_t m_liveLast;
+	PaintStats m_paintStats;
+	size_t m_pinnedTombstones;
+	size_t m_trimCount;
+};
+
+#endif // !MANAGER_H_
+
@@ -0,0 +1,182 @@
+#include "nativeformat.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <tuple>
+
+#include "manager.h"
+#include "tracer.h"
+
+namespace
+{
+	const char Magic[8] = { 'S', 'V', 'E', 'D', 'B', 'I', 'N', 0 };
+	const quint32 Version = 2;
+	const quint32 ByteOrderMark = 0x01020304;
+	const size_t MaxBlockBytes = 1 << 20;
+
+	struct Header
+	{
+		char magic[8];
+		quint32 version;
+		quint32 byteOrder;
+		quint32 elementCount;
+		quint32 styleCount;
+		qint32 pageWidth;
+		qint32 pageHeight;
+		quint32 background;
+		quint32 reserved;
+		quint64 pointCount;
+	};
+	struct Style
+	{
+		double penWidth;
+		quint32 penColor;
+		quint32 brushColor;
+		quint32 penStyle;
+		quint32 reserved;
+	};
+	static_assert(sizeof(Header) == 48, "Header must have no padding");
+	static_assert(sizeof(Style) == 24, "Style must have no padding");
+
+	typedef std::tuple<double, quint32, quint32, quint32> StyleKey;
+
+	bool writeBlock(QIODevice* device, const void* data, size_t size)
+	{
+		return size == 0 || device->write(static_cast<const char*>(data), size) == static_cast<qint64>(size);
+	}
+	template<typename T>
+	bool writeArray(QIODevice* device, const std::vector<T>& array)
+	{
+		return writeBlock(device, array.data(), array.size() * sizeof(T));
+	}
+}
+
+const char* const NativeFormat::Suffix = "sved";
+
+bool NativeFormat::isNativeFormat(const char* data, qint64 size)
+{
+	return size >= static_cast<qint64>(sizeof(Magic)) && std::memcmp(data, Magic, sizeof(Magic)) == 0;
+}
+bool NativeFormat::write(QIODevice* device, const Manager& manager, const QSize& pageSize, const QColor& background)
+{
+	TRACE_SCOPE("NativeFormat::write", "io");
+	const std::vector<std::shared_ptr<Element>>& items = manager.getItems();
+	std::vector<Style> styles;
+	std::map<StyleKey, quint32> styleIndexes;
+	std::vector<double> rects;
+	std::vector<quint64> pointOffsets(1, 0);
+	std::vector<quint32> itemStyles;
+	std::vector<quint8> types;
+	std::for_each(items.begin(), items.end(), [&](const std::shared_ptr<Element>& item)
+		{
+			if (item == nullptr)
+				return;
+			Style style = { item->getPen().widthF(), item->getPen().color().rgba(), item->getBrush().color().rgba()
+				, static_cast<quint32>(item->getPen().style()), 0 };
+			auto inserted = styleIndexes.emplace(StyleKey(style.penWidth, style.penColor, style.brushColor, style.penStyle)
+				, static_cast<quint32>(styles.size()));
+			if (inserted.second)
+				styles.push_back(style);
+			itemStyles.push_back(inserted.first->second);
+			types.push_back(static_cast<quint8>(item->getType()));
+			const QRectF& rect = item->getBoungdingRect();
+			rects.insert(rects.end(), { rect.x(), rect.y(), rect.width(), rect.height() });
+			quint64 points = item->getType() == Type::Path ? item->getPath().elementCount() : 0;
+			pointOffsets.push_back(pointOffsets.back() + points);
+		});
+
+	Header header = Header();
+	std::memcpy(header.magic, Magic, sizeof(Magic));
+	header.version = Version;
+	header.byteOrder = ByteOrderMark;
+	header.elementCount = static_cast<quint32>(types.size());
+	header.styleCount = static_cast<quint32>(styles.size());
+	header.pageWidth = pageSize.width();
+	header.pageHeight = pageSize.height();
+	header.background = background.rgba();
+	header.pointCount = pointOffsets.back();
+	if (!writeBlock(device, &header, sizeof(header)) || !writeArray(device, styles) || !writeArray(device, rects)
+		|| !writeArray(device, pointOffsets))
+		return false;
+
+	std::vector<double> block;
+	block.reserve(MaxBlockBytes / sizeof(double) + 2);
+	bool ok = true;
+	std::for_each(items.begin(), items.end(), [&](const std::shared_ptr<Element>& item)
+		{
+			if (!ok || item == nullptr || item->getType() != Type::Path)
+				return;
+			const QPainterPath& path = item->getPath();
+			for (int i = 0; ok && i < path.elementCount(); ++i)
+			{
+				block.push_back(path.elementAt(i).x);
+				block.push_back(path.elementAt(i).y);
+				if (block.size() * sizeof(double) >= MaxBlockBytes)
+				{
+					ok = writeArray(device, block);
+					block.clear();
+				}
+			}
+		});
+	return ok && writeArray(device, block) && writeArray(device, itemStyles) && writeArray(device, types);
+}
+bool NativeFormat::read(const char* data, qint64 size, std::vector<ElementBase>& items, QSize& pageSize, QColor& background)
+{
+	TRACE_SCOPE("NativeFormat::read", "io");
+	if (size < static_cast<qint64>(sizeof(Header)) || !isNativeFormat(data, size))
+		return false;
+	Header header;
+	std::memcpy(&header, data, sizeof(header));
+	quint64 count = header.elementCount;
+	if (header.version != Version || header.byteOrder != ByteOrderMark || header.pointCount > static_cast<quint64>(size) / (2 * sizeof(double)))
+		return false;
+	quint64 expected = sizeof(Header) + header.styleCount * sizeof(Style) + count * 4 * sizeof(double)
+		+ (count + 1) * sizeof(quint64) + header.pointCount * 2 * sizeof(double) + count * sizeof(quint32) + count;
+	if (expected != static_cast<quint64>(size))
+		return false;
+
+	const char* p = data + sizeof(Header);
+	const Style* styles = reinterpret_cast<const Style*>(p);
+	p += header.styleCount * sizeof(Style);
+	const double* rects = reinterpret_cast<const double*>(p);
+	p += count * 4 * sizeof(double);
+	const quint64* pointOffsets = reinterpret_cast<const quint64*>(p);
+	p += (count + 1) * sizeof(quint64);
+	const double* points = reinterpret_cast<const double*>(p);
+	p += header.pointCount * 2 * sizeof(double);
+	const quint32* itemStyles = reinterpret_cast<const quint32*>(p);
+	p += count * sizeof(quint32);
+	const quint8* types = reinterpret_cast<const quint8*>(p);
+
+	if (pointOffsets[0] != 0 || pointOffsets[count] != header.pointCount)
+		return false;
+	pageSize = QSize(header.pageWidth, header.pageHeight);
+	background = QColor::fromRgba(header.background);
+	items.reserve(items.size() + count);
+	for (quint64 i = 0; i < count; ++i)
+	{
+		Type type = static_cast<Type>(types[i]);
+		quint64 first = pointOffsets[i];
+		quint64 last = pointOffsets[i + 1];
+		if (types[i] > static_cast<quint8>(Type::Star) || itemStyles[i] >= header.styleCount || first > last || last > header.pointCount)
+			return false;
+		if (type == Type::Path && first == last)
+			return false;
+		if (type == Type::None)
+			continue;
+		QPainterPath path;
+		if (type == Type::Path)
+		{
+			path.moveTo(points[2 * first], points[2 * first + 1]);
+			for (quint64 j = first + 1; j < last; ++j)
+				path.lineTo(points[2 * j], points[2 * j + 1]);
+		}
+		const Style& style = styles[itemStyles[i]];
+		QPen pen(QColor::fromRgba(style.penColor), style.penWidth, static_cast<Qt::PenStyle>(style.penStyle));
+		QBrush brush(QColor::fromRgba(style.brushColor));
+		const double* rect = rects + 4 * i;
+		items.push_back(ElementBase(type, QRectF(rect[0], rect[1], rect[2], rect[3]), path, pen, brush));
+	}
+	return true;
+}
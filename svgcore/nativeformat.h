@@ -0,0 +1,28 @@
+#ifndef NATIVEFORMAT_H_
+#define NATIVEFORMAT_H_
+
+#include <vector>
+
+#include <QColor>
+#include <QIODevice>
+#include <QSize>
+#include <QString>
+
+#include "element.h"
+
+class Manager;
+
+// Binary document format (.sved). A fixed header is followed by flat arrays in the writer's byte
+// order: interned styles, bounding rects, point offsets, packed path points, style indexes and element
+// types. Arrays are ordered by alignment so that a mapped file can be read in place without any
+// parsing; the header records the byte order and a host with the other one rejects the file.
+class NativeFormat
+{
+public:
+	static const char* const Suffix;
+	static bool isNativeFormat(const char* data, qint64 size);
+	static bool write(QIODevice* device, const Manager& manager, const QSize& pageSize, const QColor& background);
+	static bool read(const char* data, qint64 size, std::vector<ElementBase>& items, QSize& pageSize, QColor& background);
+};
+
+#endif // !NATIVEFORMAT_H_
@@ -0,0 +1,268 @@
+#include "pngexporter.h"
+
+#include <algorithm>
+
+#include <QFile>
+#include <QImage>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QThread>
+#include <QtZlib/zlib.h>
+
+#include "manager.h"
+#include "task.h"
+#include "tracer.h"
+
+namespace
+{
+	const int DefaultStripHeight = 128;
+	const int MaxStripBytes = 16 << 20;
+
+	void appendUInt32(QByteArray& data, quint32 value)
+	{
+		data.append(static_cast<char>(value >> 24));
+		data.append(static_cast<char>(value >> 16));
+		data.append(static_cast<char>(value >> 8));
+		data.append(static_cast<char>(value));
+	}
+}
+
+PngExporter::PngExporter(const Manager& manager, const QSize& size, const QColor& background, QObject* parent)
+	: QObject(parent), m_size(size), m_background(background), m_stripHeight(DefaultStripHeight), m_level(Z_DEFAULT_COMPRESSION)
+	, m_doneCount(0), m_isCancelled(false), m_isRunning(false)
+{
+	m_pool.setMaxThreadCount(QThread::idealThreadCount() + 1);
+	const std::vector<std::shared_ptr<Element>>& items = manager.getItems();
+	m_items.reserve(items.size());
+	m_rects.reserve(items.size());
+	std::for_each(items.begin(), items.end(), [this](const std::shared_ptr<Element>& item)
+		{
+			if (!item)
+				return;
+			m_items.push_back(*item);
+			// Fill the pen's lazy dash cache here so that the painting threads only read it.
+			m_items.back().getPen().dashPattern();
+			m_rects.push_back(item->getDirtyRect());
+		});
+}
+PngExporter::~PngExporter()
+{
+	cancel();
+	m_pool.waitForDone();
+}
+void PngExporter::setStripHeight(int height)
+{
+	m_stripHeight = qMax(1, height);
+}
+void PngExporter::setCompressionLevel(int level)
+{
+	m_level = qBound(0, level, 9);
+}
+void PngExporter::setThreadCount(int count)
+{
+	m_pool.setMaxThreadCount(qMax(1, count) + 1);
+}
+void PngExporter::start(const QString& fileName)
+{
+	m_isRunning = true;
+	m_pool.start(new Task([this, fileName]
+		{
+			QFile file(fileName);
+			bool ok = false;
+			if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+				ok = exportTo(&file);
+			else
+				m_error = file.errorString();
+			file.close();
+			if (!ok)
+				QFile::remove(fileName);
+			m_isRunning = false;
+			emit finished(ok);
+		}));
+}
+bool PngExporter::exportTo(QIODevice* device)
+{
+	TRACE_SCOPE("PngExporter::exportTo", "export");
+	m_error.clear();
+	if (m_size.isEmpty())
+	{
+		m_error = "empty page";
+		return false;
+	}
+	buildIndex();
+	int width = m_size.width();
+	int height = m_size.height();
+	int stripHeight = qBound(1, MaxStripBytes / (width * 4 + 1), m_stripHeight);
+	m_stripHeight = stripHeight;
+	int count = (height + stripHeight - 1) / stripHeight;
+	int window = qMax(2, (m_pool.maxThreadCount() - 1) * 2);
+
+	QByteArray header;
+	appendUInt32(header, static_cast<quint32>(width));
+	appendUInt32(header, static_cast<quint32>(height));
+	header.append(static_cast<char>(8));
+	header.append(static_cast<char>(6));
+	header.append(3, static_cast<char>(0));
+	bool ok = device->write("\x89PNG\r\n\x1a\n", 8) == 8 && writeChunk(device, "IHDR", header);
+
+	int submitted = 0;
+	quint32 adler = 1;
+	for (int next = 0; ok && next < count; ++next)
+	{
+		for (; submitted < count && submitted < next + window; ++submitted)
+		{
+			int index = submitted;
+			m_pool.start(new Task([this, index, count]
+				{
+					stripDone(index, m_isCancelled ? Strip() : renderStrip(index, index == count - 1));
+				}));
+		}
+		Strip strip;
+		{
+			QMutexLocker locker(&m_mutex);
+			while (!m_isCancelled && m_strips.find(next) == m_strips.end())
+				m_ready.wait(&m_mutex);
+			if (m_isCancelled)
+			{
+				m_error = "cancelled";
+				ok = false;
+				break;
+			}
+			strip = std::move(m_strips.at(next));
+			m_strips.erase(next);
+		}
+		if (next == 0)
+		{
+			strip.data.prepend("\x78\x9c", 2);
+			adler = strip.adler;
+		}
+		else
+		{
+			adler = adler32_combine(adler, strip.adler, static_cast<z_off_t>(strip.length));
+		}
+		ok = writeChunk(device, "IDAT", strip.data);
+		emit progress(qMin((next + 1) * stripHeight, height), height);
+	}
+	if (ok)
+	{
+		QByteArray trailer;
+		appendUInt32(trailer, adler);
+		ok = writeChunk(device, "IDAT", trailer) && writeChunk(device, "IEND", QByteArray());
+	}
+	if (!ok && m_error.isEmpty())
+		m_error = device->errorString();
+
+	m_isCancelled = true;
+	QMutexLocker locker(&m_mutex);
+	while (m_doneCount < submitted)
+		m_ready.wait(&m_mutex);
+	m_strips.clear();
+	m_doneCount = 0;
+	m_isCancelled = false;
+	return ok;
+}
+void PngExporter::cancel()
+{
+	QMutexLocker locker(&m_mutex);
+	m_isCancelled = true;
+	m_ready.wakeAll();
+}
+bool PngExporter::isRunning() const
+{
+	return m_isRunning;
+}
+QString PngExporter::getErrorString() const
+{
+	return m_error;
+}
+// Runs on the exporting thread rather than in the constructor, which the GUI thread calls.
+void PngExporter::buildIndex()
+{
+	TRACE_SCOPE("PngExporter::buildIndex", "export");
+	for (size_t i = 0; i < m_rects.size(); ++i)
+		m_index.insert(i, m_rects.at(i));
+	std::vector<QRectF>().swap(m_rects);
+}
+PngExporter::Strip PngExporter::renderStrip(int index, bool last) const
+{
+	TRACE_SCOPE("PngExporter::renderStrip", "export");
+	int width = m_size.width();
+	int top = index * m_stripHeight;
+	int rows = qMin(m_stripHeight, m_size.height() - top);
+	QImage image(width, rows, QImage::Format_ARGB32_Premultiplied);
+	image.fill(m_background);
+
+	QRectF exposed(0, top, width, rows);
+	std::vector<size_t> indexes = m_index.query(exposed);
+	std::sort(indexes.begin(), indexes.end());
+	QPainter painter(&image);
+	painter.setRenderHint(QPainter::Antialiasing);
+	painter.translate(0, -top);
+	std::for_each(indexes.begin(), indexes.end(), [this, &painter](size_t i)
+		{
+			const ElementBase& item = m_items.at(i);
+			// QPainterPath converts itself lazily while painting, so strips never share path data.
+			QPainterPath path;
+			path.addPath(item.getPath());
+			painter.setPen(item.getPen());
+			painter.setBrush(item.getBrush());
+			painter.drawPath(path);
+		});
+	painter.end();
+	image = image.convertToFormat(QImage::Format_RGBA8888);
+
+	int stride = width * 4;
+	QByteArray raw((stride + 1) * rows, Qt::Uninitialized);
+	for (int y = 0; y < rows; ++y)
+	{
+		const uchar* line = image.constScanLine(y);
+		uchar* out = reinterpret_cast<uchar*>(raw.data()) + y * (stride + 1);
+		out[0] = 1;
+		std::copy(line, line + 4, out + 1);
+		for (int x = 4; x < stride; ++x)
+			out[x + 1] = static_cast<uchar>(line[x] - line[x - 4]);
+	}
+
+	Strip strip;
+	strip.length = raw.size();
+	strip.adler = adler32(adler32(0, nullptr, 0), reinterpret_cast<const Bytef*>(raw.constData()), raw.size());
+	z_stream stream = z_stream();
+	deflateInit2(&stream, m_level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+	strip.data.resize(static_cast<int>(deflateBound(&stream, raw.size())) + 16);
+	stream.next_in = reinterpret_cast<Bytef*>(raw.data());
+	stream.avail_in = raw.size();
+	int written = 0;
+	int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+	while (true)
+	{
+		stream.next_out = reinterpret_cast<Bytef*>(strip.data.data()) + written;
+		stream.avail_out = strip.data.size() - written;
+		int result = deflate(&stream, flush);
+		written = strip.data.size() - stream.avail_out;
+		if (result == Z_STREAM_END || (!last && stream.avail_in == 0 && stream.avail_out != 0))
+			break;
+		strip.data.resize(strip.data.size() * 2);
+	}
+	deflateEnd(&stream);
+	strip.data.resize(written);
+	return strip;
+}
+void PngExporter::stripDone(int index, Strip strip)
+{
+	QMutexLocker locker(&m_mutex);
+	if (!m_isCancelled)
+		m_strips[index] = std::move(strip);
+	++m_doneCount;
+	m_ready.wakeAll();
+}
+bool PngExporter::writeChunk(QIODevice* device, const char* type, const QByteArray& data)
+{
+	QByteArray chunk;
+	chunk.reserve(data.size() + 12);
+	appendUInt32(chunk, static_cast<quint32>(data.size()));
+	chunk.append(type, 4);
+	chunk.append(data);
+	quint32 crc = crc32(crc32(0, nullptr, 0), reinterpret_cast<const Bytef*>(chunk.constData()) + 4, data.size() + 4);
+	appendUInt32(chunk, crc);
+	return device->write(chunk) == chunk.size();
+}
@@ -0,0 +1,76 @@
+#ifndef PNGEXPORTER_H_
+#define PNGEXPORTER_H_
+
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include <QByteArray>
+#include <QColor>
+#include <QIODevice>
+#include <QMutex>
+#include <QObject>
+#include <QRectF>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include "element.h"
+#include "spatialindex.h"
+
+class Manager;
+
+// Renders a snapshot of the document into full-width strips on a thread pool and streams them into
+// the PNG in row order. Each strip is filtered and deflated by its worker; at most a small window
+// of strips is held in memory at once. The constructor only copies the items, as it runs on the
+// thread that owns the document; the spatial index over them is built when the export starts.
+class PngExporter : public QObject
+{
+	Q_OBJECT
+
+public:
+	PngExporter(const Manager& manager, const QSize& size, const QColor& background, QObject* parent = nullptr);
+	PngExporter(const PngExporter&) = delete;
+	PngExporter& operator=(const PngExporter&) = delete;
+	~PngExporter();
+	void setStripHeight(int height);
+	void setCompressionLevel(int level);
+	void setThreadCount(int count);
+	void start(const QString& fileName);
+	bool exportTo(QIODevice* device);
+	void cancel();
+	bool isRunning() const;
+	QString getErrorString() const;
+signals:
+	void progress(int rows, int total);
+	void finished(bool ok);
+private:
+	struct Strip
+	{
+		QByteArray data;
+		quint32 adler;
+		qint64 length;
+	};
+	void buildIndex();
+	Strip renderStrip(int index, bool last) const;
+	void stripDone(int index, Strip strip);
+	bool writeChunk(QIODevice* device, const char* type, const QByteArray& data);
+	std::vector<ElementBase> m_items;
+	std::vector<QRectF> m_rects;
+	SpatialIndex m_index;
+	QSize m_size;
+	QColor m_background;
+	int m_stripHeight;
+	int m_level;
+	QThreadPool m_pool;
+	QMutex m_mutex;
+	QWaitCondition m_ready;
+	std::map<int, Strip> m_strips;
+	int m_doneCount;
+	std::atomic<bool> m_isCancelled;
+	std::atomic<bool> m_isRunning;
+	QString m_error;
+};
+
+#endif // !PNGEXPORTER_H_
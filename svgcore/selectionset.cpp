@@ -0,0 +1,63 @@
+#include "selectionset.h"
+
+#include <algorithm>
+
+bool SelectionSet::insert(ElementId id)
+{
+	if (contains(id))
+		return false;
+	size_t word = static_cast<size_t>(id / 64);
+	if (word >= m_bits.size())
+		m_bits.resize(qMax(word + 1, m_bits.size() * 2), 0);
+	m_bits.at(word) |= quint64(1) << (id % 64);
+	m_ids.push_back(id);
+	return true;
+}
+bool SelectionSet::erase(ElementId id)
+{
+	if (!contains(id))
+		return false;
+	m_bits.at(static_cast<size_t>(id / 64)) &= ~(quint64(1) << (id % 64));
+	auto iter = std::find(m_ids.begin(), m_ids.end(), id);
+	*iter = m_ids.back();
+	m_ids.pop_back();
+	return true;
+}
+// Erases many IDs in one pass over the selection instead of one search each.
+void SelectionSet::erase(const std::vector<ElementId>& ids)
+{
+	std::for_each(ids.begin(), ids.end(), [this](ElementId id)
+		{
+			if (contains(id))
+				m_bits.at(static_cast<size_t>(id / 64)) &= ~(quint64(1) << (id % 64));
+		});
+	m_ids.erase(std::remove_if(m_ids.begin(), m_ids.end(), [this](ElementId id)
+		{
+			return !contains(id);
+		}), m_ids.end());
+}
+void SelectionSet::clear()
+{
+	std::for_each(m_ids.begin(), m_ids.end(), [this](ElementId id)
+		{
+			m_bits.at(static_cast<size_t>(id / 64)) = 0;
+		});
+	m_ids.clear();
+}
+bool SelectionSet::contains(ElementId id) const
+{
+	size_t word = static_cast<size_t>(id / 64);
+	return word < m_bits.size() && (m_bits.at(word) >> (id % 64) & 1) != 0;
+}
+bool SelectionSet::isEmpty() const
+{
+	return m_ids.empty();
+}
+size_t SelectionSet::getCount() const
+{
+	return m_ids.size();
+}
+const std::vector<ElementId>& SelectionSet::getIds() const
+{
+	return m_ids;
+}
@@ -0,0 +1,35 @@
+#ifndef SELECTIONSET_H_
+#define SELECTIONSET_H_
+
+#include <vector>
+
+#include <QtGlobal>
+
+#include "element.h"
+
+// The selected elements of a Manager: their IDs in selection order plus a bitset indexed by ID for
+// membership tests. Every operation costs time in the number of selected elements, not in the size
+// of the document.
+class SelectionSet
+{
+public:
+	SelectionSet() = default;
+	SelectionSet(const SelectionSet&) = default;
+	SelectionSet(SelectionSet&&) = default;
+	SelectionSet& operator=(const SelectionSet&) = default;
+	SelectionSet& operator=(SelectionSet&&) = default;
+	~SelectionSet() = default;
+	bool insert(ElementId id);
+	bool erase(ElementId id);
+	void erase(const std::vector<ElementId>& ids);
+	void clear();
+	bool contains(ElementId id) const;
+	bool isEmpty() const;
+	size_t getCount() const;
+	const std::vector<ElementId>& getIds() const;
+private:
+	std::vector<ElementId> m_ids;
+	std::vector<quint64> m_bits;
+};
+
+#endif // !SELECTIONSET_H_
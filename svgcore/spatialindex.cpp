@@ -0,0 +1,427 @@
+#include "spatialindex.h"
+
+#include <algorithm>
+#include <limits>
+
+SpatialIndex::Box::Box(double l, double t, double r, double b)
+	: left(l)
+	, top(t)
+	, right(r)
+	, bottom(b)
+{
+}
+SpatialIndex::Box::Box(const QRectF& rect)
+	: left(qMin(rect.left(), rect.right()))
+	, top(qMin(rect.top(), rect.bottom()))
+	, right(qMax(rect.left(), rect.right()))
+	, bottom(qMax(rect.top(), rect.bottom()))
+{
+}
+double SpatialIndex::Box::area() const
+{
+	return (right - left) * (bottom - top);
+}
+SpatialIndex::Box SpatialIndex::Box::united(const Box& other) const
+{
+	return Box(qMin(left, other.left), qMin(top, other.top), qMax(right, other.right), qMax(bottom, other.bottom));
+}
+bool SpatialIndex::Box::intersects(const Box& other) const
+{
+	return left <= other.right && other.left <= right && top <= other.bottom && other.top <= bottom;
+}
+
+SpatialIndex::SpatialIndex()
+{
+	clear();
+}
+SpatialIndex::SpatialIndex(const SpatialIndex& other)
+{
+	*this = other;
+}
+SpatialIndex& SpatialIndex::operator=(const SpatialIndex& other)
+{
+	if (this == &other)
+		return *this;
+	clear();
+	for (size_t i = 0; i < other.m_leaves.size(); ++i)
+	{
+		if (other.m_leaves.at(i) != nullptr)
+			insert(i, QRectF(QPointF(other.m_boxes.at(i).left, other.m_boxes.at(i).top)
+				, QPointF(other.m_boxes.at(i).right, other.m_boxes.at(i).bottom)));
+	}
+	return *this;
+}
+void SpatialIndex::insert(size_t slot, const QRectF& rect)
+{
+	if (slot >= m_leaves.size())
+	{
+		m_leaves.resize(slot + 1, nullptr);
+		m_boxes.resize(slot + 1);
+	}
+	if (m_leaves.at(slot) != nullptr)
+		remove(slot);
+	m_boxes.at(slot) = Box(rect);
+	insertEntry(Entry{ m_boxes.at(slot), slot });
+	++m_count;
+}
+void SpatialIndex::remove(size_t slot)
+{
+	if (!contains(slot))
+		return;
+	Node* node = m_leaves.at(slot);
+	m_leaves.at(slot) = nullptr;
+	--m_count;
+	node->entries.erase(std::find_if(node->entries.begin(), node->entries.end(), [slot](const Entry& entry)
+		{
+			return entry.slot == slot;
+		}));
+	std::vector<Entry> orphans;
+	while (node != m_root.get())
+	{
+		Node* parent = node->parent;
+		size_t count = node->leaf ? node->entries.size() : node->children.size();
+		if (count < MinEntries)
+		{
+			collectEntries(node, orphans);
+			parent->children.erase(std::find_if(parent->children.begin(), parent->children.end(), [node](const std::unique_ptr<Node>& child)
+				{
+					return child.get() == node;
+				}));
+		}
+		else
+		{
+			recomputeBox(node);
+		}
+		node = parent;
+	}
+	recomputeBox(m_root.get());
+	while (!m_root->leaf && m_root->children.size() == 1)
+	{
+		std::unique_ptr<Node> child = std::move(m_root->children.front());
+		child->parent = nullptr;
+		m_root = std::move(child);
+	}
+	if (!m_root->leaf && m_root->children.empty())
+	{
+		m_root->leaf = true;
+	}
+	std::for_each(orphans.begin(), orphans.end(), [this](const Entry& entry)
+		{
+			insertEntry(entry);
+		});
+}
+void SpatialIndex::update(size_t slot, const QRectF& rect)
+{
+	if (contains(slot))
+	{
+		Box box(rect);
+		const Box& old = m_boxes.at(slot);
+		if (box.left == old.left && box.top == old.top && box.right == old.right && box.bottom == old.bottom)
+			return;
+	}
+	insert(slot, rect);
+}
+void SpatialIndex::swap(size_t slot1, size_t slot2)
+{
+	if (slot1 == slot2)
+		return;
+	size_t size = qMax(slot1, slot2) + 1;
+	if (size > m_leaves.size())
+	{
+		m_leaves.resize(size, nullptr);
+		m_boxes.resize(size);
+	}
+	auto relabel = [slot1, slot2](Node* leaf)
+	{
+		if (leaf != nullptr)
+			for (Entry& entry : leaf->entries)
+			{
+				if (entry.slot == slot1)
+					entry.slot = slot2;
+				else if (entry.slot == slot2)
+					entry.slot = slot1;
+			}
+	};
+	relabel(m_leaves.at(slot1));
+	if (m_leaves.at(slot2) != m_leaves.at(slot1))
+		relabel(m_leaves.at(slot2));
+	std::swap(m_leaves.at(slot1), m_leaves.at(slot2));
+	std::swap(m_boxes.at(slot1), m_boxes.at(slot2));
+}
+void SpatialIndex::clear()
+{
+	m_root = std::make_unique<Node>();
+	m_root->box = Box(0, 0, 0, 0);
+	m_root->leaf = true;
+	m_root->parent = nullptr;
+	m_boxes.clear();
+	m_leaves.clear();
+	m_count = 0;
+}
+// Relabels every entry from slot to map[slot] without rebuilding the tree; size is the new slot count.
+void SpatialIndex::remap(const std::vector<size_t>& map, size_t size)
+{
+	std::vector<Node*> leaves(size, nullptr);
+	std::vector<Box> boxes(size);
+	for (size_t i = 0; i < m_leaves.size(); ++i)
+	{
+		if (m_leaves.at(i) != nullptr)
+		{
+			leaves.at(map.at(i)) = m_leaves.at(i);
+			boxes.at(map.at(i)) = m_boxes.at(i);
+		}
+	}
+	remapEntries(m_root.get(), map);
+	m_leaves.swap(leaves);
+	m_boxes.swap(boxes);
+}
+bool SpatialIndex::contains(size_t slot) const
+{
+	return slot < m_leaves.size() && m_leaves.at(slot) != nullptr;
+}
+size_t SpatialIndex::getCount() const
+{
+	return m_count;
+}
+std::vector<size_t> SpatialIndex::query(const QPointF& pos, double margin) const
+{
+	std::vector<size_t> result;
+	query(Box(pos.x() - margin, pos.y() - margin, pos.x() + margin, pos.y() + margin), result);
+	return result;
+}
+std::vector<size_t> SpatialIndex::query(const QRectF& rect) const
+{
+	std::vector<size_t> result;
+	query(Box(rect), result);
+	return result;
+}
+
+std::vector<int> SpatialIndex::partition(const std::vector<Box>& boxes)
+{
+	std::vector<int> groups(boxes.size(), -1);
+	size_t seed1 = 0;
+	size_t seed2 = 1;
+	double worst = -std::numeric_limits<double>::infinity();
+	for (size_t i = 0; i < boxes.size(); ++i)
+	{
+		for (size_t j = i + 1; j < boxes.size(); ++j)
+		{
+			double waste = boxes.at(i).united(boxes.at(j)).area() - boxes.at(i).area() - boxes.at(j).area();
+			if (waste > worst)
+			{
+				worst = waste;
+				seed1 = i;
+				seed2 = j;
+			}
+		}
+	}
+	Box cover[2]{ boxes.at(seed1), boxes.at(seed2) };
+	size_t count[2]{ 1, 1 };
+	groups.at(seed1) = 0;
+	groups.at(seed2) = 1;
+	size_t remaining = boxes.size() - 2;
+	while (remaining > 0)
+	{
+		for (int g = 0; g < 2; ++g)
+		{
+			if (count[g] + remaining <= MinEntries)
+			{
+				for (size_t i = 0; i < boxes.size(); ++i)
+					if (groups.at(i) == -1)
+						groups.at(i) = g;
+				return groups;
+			}
+		}
+		size_t next = 0;
+		double bestDiff = -1;
+		double grow[2]{ 0, 0 };
+		for (size_t i = 0; i < boxes.size(); ++i)
+		{
+			if (groups.at(i) != -1)
+				continue;
+			double d0 = cover[0].united(boxes.at(i)).area() - cover[0].area();
+			double d1 = cover[1].united(boxes.at(i)).area() - cover[1].area();
+			if (qAbs(d0 - d1) > bestDiff)
+			{
+				bestDiff = qAbs(d0 - d1);
+				next = i;
+				grow[0] = d0;
+				grow[1] = d1;
+			}
+		}
+		int g = 0;
+		if (grow[1] < grow[0])
+			g = 1;
+		else if (grow[0] == grow[1])
+			g = cover[1].area() < cover[0].area() || (cover[1].area() == cover[0].area() && count[1] < count[0]) ? 1 : 0;
+		groups.at(next) = g;
+		cover[g] = cover[g].united(boxes.at(next));
+		++count[g];
+		--remaining;
+	}
+	return groups;
+}
+void SpatialIndex::insertEntry(const Entry& entry)
+{
+	std::unique_ptr<Node> sibling = insertEntry(m_root.get(), entry);
+	if (sibling != nullptr)
+	{
+		std::unique_ptr<Node> root = std::make_unique<Node>();
+		root->leaf = false;
+		root->parent = nullptr;
+		root->box = m_root->box.united(sibling->box);
+		m_root->parent = root.get();
+		sibling->parent = root.get();
+		root->children.push_back(std::move(m_root));
+		root->children.push_back(std::move(sibling));
+		m_root = std::move(root);
+	}
+}
+std::unique_ptr<SpatialIndex::Node> SpatialIndex::insertEntry(Node* node, const Entry& entry)
+{
+	bool empty = node->leaf ? node->entries.empty() : node->children.empty();
+	node->box = empty ? entry.box : node->box.united(entry.box);
+	if (node->leaf)
+	{
+		node->entries.push_back(entry);
+		m_leaves.at(entry.slot) = node;
+		return node->entries.size() > MaxEntries ? splitLeaf(node) : nullptr;
+	}
+	Node* target = nullptr;
+	double bestGrow = std::numeric_limits<double>::infinity();
+	double bestArea = std::numeric_limits<double>::infinity();
+	for (const std::unique_ptr<Node>& child : node->children)
+	{
+		double area = child->box.area();
+		double grow = child->box.united(entry.box).area() - area;
+		if (grow < bestGrow || (grow == bestGrow && area < bestArea))
+		{
+			target = child.get();
+			bestGrow = grow;
+			bestArea = area;
+		}
+	}
+	std::unique_ptr<Node> sibling = insertEntry(target, entry);
+	if (sibling != nullptr)
+	{
+		sibling->parent = node;
+		node->children.push_back(std::move(sibling));
+		if (node->children.size() > MaxEntries)
+			return splitBranch(node);
+	}
+	return nullptr;
+}
+std::unique_ptr<SpatialIndex::Node> SpatialIndex::splitLeaf(Node* node)
+{
+	std::vector<Box> boxes;
+	for (const Entry& entry : node->entries)
+		boxes.push_back(entry.box);
+	std::vector<int> groups = partition(boxes);
+	std::vector<Entry> entries = std::move(node->entries);
+	node->entries.clear();
+	std::unique_ptr<Node> sibling = std::make_unique<Node>();
+	sibling->leaf = true;
+	sibling->parent = node->parent;
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		Node* target = groups.at(i) == 0 ? node : sibling.get();
+		target->entries.push_back(entries.at(i));
+		m_leaves.at(entries.at(i).slot) = target;
+	}
+	recomputeBox(node);
+	recomputeBox(sibling.get());
+	return sibling;
+}
+std::unique_ptr<SpatialIndex::Node> SpatialIndex::splitBranch(Node* node)
+{
+	std::vector<Box> boxes;
+	for (const std::unique_ptr<Node>& child : node->children)
+		boxes.push_back(child->box);
+	std::vector<int> groups = partition(boxes);
+	std::vector<std::unique_ptr<Node>> children = std::move(node->children);
+	node->children.clear();
+	std::unique_ptr<Node> sibling = std::make_unique<Node>();
+	sibling->leaf = false;
+	sibling->parent = node->parent;
+	for (size_t i = 0; i < children.size(); ++i)
+	{
+		Node* target = groups.at(i) == 0 ? node : sibling.get();
+		children.at(i)->parent = target;
+		target->children.push_back(std::move(children.at(i)));
+	}
+	recomputeBox(node);
+	recomputeBox(sibling.get());
+	return sibling;
+}
+void SpatialIndex::recomputeBox(Node* node)
+{
+	if (node->leaf)
+	{
+		if (node->entries.empty())
+			return;
+		node->box = node->entries.front().box;
+		for (const Entry& entry : node->entries)
+			node->box = node->box.united(entry.box);
+	}
+	else
+	{
+		if (node->children.empty())
+			return;
+		node->box = node->children.front()->box;
+		for (const std::unique_ptr<Node>& child : node->children)
+			node->box = node->box.united(child->box);
+	}
+}
+void SpatialIndex::collectEntries(Node* node, std::vector<Entry>& entries)
+{
+	if (node->leaf)
+	{
+		for (const Entry& entry : node->entries)
+		{
+			m_leaves.at(entry.slot) = nullptr;
+			entries.push_back(entry);
+		}
+	}
+	else
+	{
+		for (const std::unique_ptr<Node>& child : node->children)
+			collectEntries(child.get(), entries);
+	}
+}
+void SpatialIndex::remapEntries(Node* node, const std::vector<size_t>& map)
+{
+	if (node->leaf)
+	{
+		for (Entry& entry : node->entries)
+			entry.slot = map.at(entry.slot);
+	}
+	else
+	{
+		for (const std::unique_ptr<Node>& child : node->children)
+			remapEntries(child.get(), map);
+	}
+}
+void SpatialIndex::query(const Box& box, std::vector<size_t>& result) const
+{
+	if (m_root->leaf && m_root->entries.empty())
+		return;
+	std::vector<const Node*> stack{ m_root.get() };
+	while (!stack.empty())
+	{
+		const Node* node = stack.back();
+		stack.pop_back();
+		if (!node->box.intersects(box))
+			continue;
+		if (node->leaf)
+		{
+			for (const Entry& entry : node->entries)
+				if (entry.box.intersects(box))
+					result.push_back(entry.slot);
+		}
+		else
+		{
+			for (const std::unique_ptr<Node>& child : node->children)
+				stack.push_back(child.get());
+		}
+	}
+}
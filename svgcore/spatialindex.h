@@ -0,0 +1,75 @@
+#ifndef SPATIALINDEX_H_
+#define SPATIALINDEX_H_
+
+#include <memory>
+#include <vector>
+
+#include <QPointF>
+#include <QRectF>
+
+// R-tree over the bounding rects of Manager::m_items, keyed by slot in that vector.
+// Queries return a superset of the slots whose rect touches the query; callers apply exact tests.
+class SpatialIndex
+{
+public:
+	SpatialIndex();
+	SpatialIndex(const SpatialIndex& other);
+	SpatialIndex(SpatialIndex&&) = default;
+	SpatialIndex& operator=(const SpatialIndex& other);
+	SpatialIndex& operator=(SpatialIndex&&) = default;
+	~SpatialIndex() = default;
+	void insert(size_t slot, const QRectF& rect);
+	void remove(size_t slot);
+	void update(size_t slot, const QRectF& rect);
+	void swap(size_t slot1, size_t slot2);
+	void clear();
+	void remap(const std::vector<size_t>& map, size_t size);
+	bool contains(size_t slot) const;
+	size_t getCount() const;
+	std::vector<size_t> query(const QPointF& pos, double margin) const;
+	std::vector<size_t> query(const QRectF& rect) const;
+private:
+	struct Box
+	{
+		Box() = default;
+		Box(double l, double t, double r, double b);
+		explicit Box(const QRectF& rect);
+		double area() const;
+		Box united(const Box& other) const;
+		bool intersects(const Box& other) const;
+		double left;
+		double top;
+		double right;
+		double bottom;
+	};
+	struct Entry
+	{
+		Box box;
+		size_t slot;
+	};
+	struct Node
+	{
+		Box box;
+		bool leaf;
+		Node* parent;
+		std::vector<Entry> entries;
+		std::vector<std::unique_ptr<Node>> children;
+	};
+	static const size_t MaxEntries = 16;
+	static const size_t MinEntries = 6;
+	static std::vector<int> partition(const std::vector<Box>& boxes);
+	void insertEntry(const Entry& entry);
+	std::unique_ptr<Node> insertEntry(Node* node, const Entry& entry);
+	std::unique_ptr<Node> splitLeaf(Node* node);
+	std::unique_ptr<Node> splitBranch(Node* node);
+	void recomputeBox(Node* node);
+	void collectEntries(Node* node, std::vector<Entry>& entries);
+	void remapEntries(Node* node, const std::vector<size_t>& map);
+	void query(const Box& box, std::vector<size_t>& result) const;
+	std::unique_ptr<Node> m_root;
+	std::vector<Box> m_boxes;
+	std::vector<Node*> m_leaves;
+	size_t m_count;
+};
+
+#endif // !SPATIALINDEX_H_
@@ -0,0 +1,91 @@
+#include "strokefilter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const size_t MaxRunLength = 64;
+}
+
+double distanceToSegment(const QPointF& point, const QPointF& start, const QPointF& end)
+{
+	QPointF segment = end - start;
+	double length = QPointF::dotProduct(segment, segment);
+	double t = length > 0 ? QPointF::dotProduct(point - start, segment) / length : 0;
+	QPointF offset = point - (start + segment * qBound(0.0, t, 1.0));
+	return std::sqrt(QPointF::dotProduct(offset, offset));
+}
+
+StrokeFilter::StrokeFilter() :StrokeFilter(0.75, 0)
+{
+}
+StrokeFilter::StrokeFilter(double tolerance, double smoothing)
+	: m_tolerance(tolerance)
+	, m_smoothing(smoothing)
+{
+}
+void StrokeFilter::setTolerance(double tolerance)
+{
+	m_tolerance = qMax(tolerance, 0.0);
+}
+void StrokeFilter::setSmoothing(double smoothing)
+{
+	m_smoothing = qBound(0.0, smoothing, 0.95);
+}
+double StrokeFilter::getTolerance() const
+{
+	return m_tolerance;
+}
+double StrokeFilter::getSmoothing() const
+{
+	return m_smoothing;
+}
+void StrokeFilter::begin(const QPointF& pos)
+{
+	m_smoothed = pos;
+	m_last = pos;
+	m_anchor = pos;
+	m_run.clear();
+}
+Capture StrokeFilter::push(const QPointF& pos, QPointF& point)
+{
+	m_last = pos;
+	m_smoothed += (pos - m_smoothed) * (1 - m_smoothing);
+	point = m_smoothed;
+	return capture(point);
+}
+// The smoothed point trails the cursor, so when the stroke ends it is moved onto the last position.
+Capture StrokeFilter::finish(QPointF& point)
+{
+	if (m_smoothed == m_last)
+		return Capture::Skip;
+	m_smoothed = m_last;
+	point = m_last;
+	return capture(point);
+}
+Capture StrokeFilter::capture(const QPointF& point)
+{
+	if (m_run.empty())
+	{
+		if (distanceToSegment(point, m_anchor, m_anchor) < m_tolerance)
+			return Capture::Skip;
+		m_run.push_back(point);
+		return Capture::Append;
+	}
+	if (m_run.size() < MaxRunLength && isRunWithin(point))
+	{
+		m_run.push_back(point);
+		return Capture::Replace;
+	}
+	m_anchor = m_run.back();
+	m_run.assign(1, point);
+	return Capture::Append;
+}
+bool StrokeFilter::isRunWithin(const QPointF& end) const
+{
+	return std::all_of(m_run.begin(), m_run.end(), [this, &end](const QPointF& point)
+		{
+			return distanceToSegment(point, m_anchor, end) <= m_tolerance;
+		});
+}
@@ -0,0 +1,40 @@
+#ifndef STROKEFILTER_H_
+#define STROKEFILTER_H_
+
+#include <vector>
+
+#include <QPointF>
+
+enum class Capture { Skip, Append, Replace };
+
+double distanceToSegment(const QPointF& point, const QPointF& start, const QPointF& end);
+
+class StrokeFilter
+{
+public:
+	StrokeFilter();
+	StrokeFilter(double tolerance, double smoothing);
+	StrokeFilter(const StrokeFilter&) = default;
+	StrokeFilter(StrokeFilter&&) = default;
+	StrokeFilter& operator=(const StrokeFilter&) = default;
+	StrokeFilter& operator=(StrokeFilter&&) = default;
+	~StrokeFilter() = default;
+	void setTolerance(double tolerance);
+	void setSmoothing(double smoothing);
+	double getTolerance() const;
+	double getSmoothing() const;
+	void begin(const QPointF& pos);
+	Capture push(const QPointF& pos, QPointF& point);
+	Capture finish(QPointF& point);
+private:
+	Capture capture(const QPointF& point);
+	bool isRunWithin(const QPointF& end) const;
+	double m_tolerance;
+	double m_smoothing;
+	QPointF m_smoothed;
+	QPointF m_last;
+	QPointF m_anchor;
+	std::vector<QPointF> m_run;
+};
+
+#endif // !STROKEFILTER_H_
@@ -0,0 +1,438 @@
+#include "svgloader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutexLocker>
+#include <QThread>
+
+#include "gzipdevice.h"
+#include "nativeformat.h"
+#include "svgpathparser.h"
+#include "task.h"
+#include "tracer.h"
+
+namespace
+{
+	const size_t MaxBatchSize = 4096;
+	const qint64 BatchInterval = 50;
+	const size_t MinChunkSize = 256 << 10;
+	const size_t MaxChunkSize = 4 << 20;
+	const size_t FeedBlockSize = 64 << 10;
+
+	typedef std::pair<const char*, const char*> Range;
+
+	const char* find(const char* begin, const char* end, const char* token)
+	{
+		const char* found = std::search(begin, end, token, token + std::strlen(token));
+		return found == end ? nullptr : found + std::strlen(token);
+	}
+	bool startsWith(const char* begin, const char* end, const char* token)
+	{
+		size_t length = std::strlen(token);
+		return static_cast<size_t>(end - begin) >= length && std::equal(token, token + length, begin);
+	}
+	// Returns the position after the markup starting at begin (a '<'), or nullptr if it is not closed.
+	// depth is set to 1 for a start tag, -1 for an end tag and 0 for anything that does not nest.
+	const char* skipMarkup(const char* begin, const char* end, int& depth)
+	{
+		depth = 0;
+		if (startsWith(begin, end, "<!--"))
+			return find(begin + 4, end, "-->");
+		if (startsWith(begin, end, "<![CDATA["))
+			return find(begin + 9, end, "]]>");
+		if (startsWith(begin, end, "<?"))
+			return find(begin + 2, end, "?>");
+		char quote = 0;
+		for (const char* p = begin + 1; p != end; ++p)
+		{
+			if (quote != 0)
+			{
+				if (*p == quote)
+					quote = 0;
+			}
+			else if (*p == '"' || *p == '\'')
+			{
+				quote = *p;
+			}
+			else if (*p == '>')
+			{
+				if (begin[1] == '/')
+					depth = -1;
+				else if (begin[1] != '!' && p[-1] != '/')
+					depth = 1;
+				return p + 1;
+			}
+		}
+		return nullptr;
+	}
+	// Splits the children of the root element into ranges of whole elements of about chunkSize bytes.
+	// prolog receives everything up to and including the root start tag, DOCTYPE and its entities
+	// included, and epilog the matching end tag, so that either side of a range makes it parse on its own.
+	bool splitDocument(const char* begin, const char* end, size_t chunkSize, QByteArray& prolog, QByteArray& epilog, std::vector<Range>& ranges)
+	{
+		const char* p = begin;
+		int depth = 0;
+		const char* rootBegin = nullptr;
+		while (rootBegin == nullptr)
+		{
+			p = std::find(p, end, '<');
+			if (p == end)
+				return false;
+			const char* next = skipMarkup(p, end, depth);
+			if (next == nullptr || depth < 0)
+				return false;
+			if (depth > 0)
+				rootBegin = p;
+			p = next;
+		}
+		const char* nameEnd = std::find_if(rootBegin + 1, p, [](char c)
+			{
+				return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '/' || c == '>';
+			});
+		prolog = QByteArray(begin, static_cast<int>(p - begin));
+		epilog = QByteArray("</").append(rootBegin + 1, static_cast<int>(nameEnd - rootBegin - 1)).append(">");
+
+		const char* chunkBegin = p;
+		int level = 0;
+		while (true)
+		{
+			p = std::find(p, end, '<');
+			if (p == end)
+				return false;
+			const char* next = skipMarkup(p, end, depth);
+			if (next == nullptr)
+				return false;
+			if (level == 0 && depth < 0)
+				break;
+			level += depth;
+			p = next;
+			if (level == 0 && static_cast<size_t>(p - chunkBegin) >= chunkSize)
+			{
+				ranges.push_back(Range(chunkBegin, p));
+				chunkBegin = p;
+			}
+		}
+		if (p != chunkBegin)
+			ranges.push_back(Range(chunkBegin, p));
+		return true;
+	}
+}
+
+SvgLoader::SvgLoader(QObject* parent)
+	: QObject(parent), m_isNotified(false), m_doneCount(0), m_isCancelled(false), m_isRunning(false)
+{
+	m_pool.setMaxThreadCount(QThread::idealThreadCount() + 1);
+}
+SvgLoader::~SvgLoader()
+{
+	cancel();
+	m_pool.waitForDone();
+}
+void SvgLoader::start(const QString& fileName)
+{
+	m_isRunning = true;
+	m_pool.start(new Task([this, fileName]
+		{
+			bool ok = load(fileName);
+			m_isRunning = false;
+			emit finished(ok);
+		}));
+}
+bool SvgLoader::load(const QString& fileName)
+{
+	TRACE_SCOPE("SvgLoader::load", "io");
+	m_error.clear();
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		m_error = file.errorString();
+		return false;
+	}
+	qint64 size = file.size();
+	bool isCompressed = file.peek(2) == QByteArray("\x1f\x8b", 2);
+	const uchar* data = size > 0 && !isCompressed ? file.map(0, size) : nullptr;
+	const char* begin = reinterpret_cast<const char*>(data);
+	if (isCompressed)
+	{
+		GzipReader gzip(&file);
+		gzip.open(QIODevice::ReadOnly);
+		QXmlStreamReader reader(&gzip);
+		readSequential(reader, size, &file);
+		if (gzip.hasError())
+			m_error = gzip.errorString();
+	}
+	else if (data != nullptr && NativeFormat::isNativeFormat(begin, size))
+	{
+		readNative(begin, size);
+	}
+	else if (data != nullptr && size <= std::numeric_limits<int>::max())
+	{
+		readParallel(begin, begin + size);
+	}
+	else
+	{
+		QXmlStreamReader reader(&file);
+		readSequential(reader, size, &file);
+	}
+	if (data != nullptr)
+		file.unmap(const_cast<uchar*>(data));
+	if (m_isCancelled && m_error.isEmpty())
+		m_error = "cancelled";
+	else if (m_error.isEmpty())
+		emit progress(size, size);
+	return m_error.isEmpty();
+}
+void SvgLoader::setThreadCount(int count)
+{
+	m_pool.setMaxThreadCount(qMax(1, count) + 1);
+}
+void SvgLoader::cancel()
+{
+	QMutexLocker locker(&m_mutex);
+	m_isCancelled = true;
+	m_ready.wakeAll();
+}
+bool SvgLoader::isRunning() const
+{
+	return m_isRunning;
+}
+std::vector<ElementBase> SvgLoader::takeItems()
+{
+	QMutexLocker locker(&m_mutex);
+	m_isNotified = false;
+	std::vector<ElementBase> items;
+	items.swap(m_items);
+	return items;
+}
+QString SvgLoader::getErrorString() const
+{
+	return m_error;
+}
+bool SvgLoader::parseElement(const QXmlStreamReader& reader, ElementBase& item)
+{
+	QXmlStreamAttributes attributes = reader.attributes();
+	QRectF rect;
+	QPainterPath path;
+	Type type = Type::None;
+	if (reader.name() == "line")
+	{
+		qreal x1 = attributes.value("x1").toDouble();
+		qreal y1 = attributes.value("y1").toDouble();
+		qreal x2 = attributes.value("x2").toDouble();
+		qreal y2 = attributes.value("y2").toDouble();
+		rect.setTopLeft(QPointF(x1, y1));
+		rect.setBottomRight(QPointF(x2, y2));
+		type = Type::Line;
+	}
+	else if (reader.name() == "path")
+	{
+		// As SVG renderers do, a path with malformed data keeps what was read before the error.
+		SvgPathParser parser(attributes.value("d"));
+		if (!parser.parse(path))
+		{
+			int position = parser.getErrorPosition();
+			QString error = position < 0 ? QString("unexpected end of path data") : QString("invalid path data at character %1").arg(position);
+			qWarning("%s", qPrintable(error));
+		}
+		if (!path.isEmpty())
+		{
+			rect = path.boundingRect();
+			type = Type::Path;
+		}
+	}
+	else if (reader.name() == "ellipse")
+	{
+		qreal cx = attributes.value("cx").toDouble();
+		qreal cy = attributes.value("cy").toDouble();
+		qreal rx = attributes.value("rx").toDouble();
+		qreal ry = attributes.value("ry").toDouble();
+		rect = QRectF(cx - rx, cy - ry, 2 * rx, 2 * ry);
+		type = Type::Ellipse;
+	}
+	else if (reader.name() == "rect")
+	{
+		qreal x = attributes.value("x").toDouble();
+		qreal y = attributes.value("y").toDouble();
+		qreal width = attributes.value("width").toDouble();
+		qreal height = attributes.value("height").toDouble();
+		rect = QRectF(x, y, width, height);
+		type = Type::Rect;
+	}
+	if (type == Type::None)
+		return false;
+	QStringRef strokeDashArray = attributes.value("stroke-dasharray");
+	Qt::PenStyle style = Qt::PenStyle::SolidLine;
+	if (strokeDashArray == "10,5")
+		style = Qt::PenStyle::DashLine;
+	if (strokeDashArray == "1,5")
+		style = Qt::PenStyle::DotLine;
+	if (strokeDashArray == "10,5,1,5")
+		style = Qt::PenStyle::DashDotLine;
+	if (strokeDashArray == "10,5,1,5,1,5")
+		style = Qt::PenStyle::DashDotDotLine;
+	QPen pen(QColor(attributes.value("stroke").toString()), attributes.value("stroke-width").toDouble(), style);
+	QBrush brush(QColor(attributes.value("fill").toString()));
+	item = ElementBase(type, rect, path, pen, brush);
+	return true;
+}
+void SvgLoader::readNative(const char* data, qint64 size)
+{
+	std::vector<ElementBase> items;
+	QSize pageSize;
+	QColor background;
+	if (!NativeFormat::read(data, size, items, pageSize, background))
+	{
+		m_error = "invalid document";
+		return;
+	}
+	emit pageSizeParsed(pageSize.width(), pageSize.height());
+	emit backGroundColorParsed(background);
+	pushItems(items);
+}
+void SvgLoader::readSequential(QXmlStreamReader& reader, qint64 size, const QIODevice* source)
+{
+	std::vector<ElementBase> batch;
+	QElapsedTimer timer;
+	timer.start();
+	while (!m_isCancelled && !reader.atEnd() && !reader.hasError())
+	{
+		if (reader.readNext() != QXmlStreamReader::StartElement)
+			continue;
+		if (reader.name() == "svg")
+		{
+			QXmlStreamAttributes attributes = reader.attributes();
+			emit pageSizeParsed(attributes.value("width").toInt(), attributes.value("height").toInt());
+			continue;
+		}
+		ElementBase item;
+		if (parseElement(reader, item))
+			batch.push_back(std::move(item));
+		if (batch.size() >= MaxBatchSize || (!batch.empty() && timer.elapsed() >= BatchInterval))
+		{
+			pushItems(batch);
+			emit progress(source != nullptr ? source->pos() : reader.characterOffset(), size);
+			timer.restart();
+		}
+	}
+	pushItems(batch);
+	if (reader.hasError())
+		m_error = reader.errorString();
+}
+void SvgLoader::readParallel(const char* begin, const char* end)
+{
+	QByteArray prolog;
+	QByteArray epilog;
+	std::vector<Range> ranges;
+	int threads = m_pool.maxThreadCount() - 1;
+	size_t chunkSize = qBound<size_t>(MinChunkSize, (end - begin) / (threads * 8), MaxChunkSize);
+	if (threads < 2 || !splitDocument(begin, end, chunkSize, prolog, epilog, ranges))
+	{
+		QXmlStreamReader reader(QByteArray::fromRawData(begin, static_cast<int>(end - begin)));
+		readSequential(reader, end - begin);
+		return;
+	}
+	QXmlStreamReader reader(prolog + epilog);
+	readSequential(reader, end - begin);
+	if (!m_error.isEmpty())
+		return;
+
+	int count = static_cast<int>(ranges.size());
+	int window = threads * 2;
+	int submitted = 0;
+	for (int next = 0; next < count; ++next)
+	{
+		for (; submitted < count && submitted < next + window; ++submitted)
+		{
+			Range range = ranges.at(submitted);
+			int index = submitted;
+			m_pool.start(new Task([this, &prolog, &epilog, range, index]
+				{
+					Chunk chunk = readChunk(prolog, epilog, range.first, range.second);
+					QMutexLocker locker(&m_mutex);
+					m_chunks[index] = std::move(chunk);
+					++m_doneCount;
+					m_ready.wakeAll();
+				}));
+		}
+		Chunk chunk;
+		{
+			QMutexLocker locker(&m_mutex);
+			while (!m_isCancelled && m_chunks.find(next) == m_chunks.end())
+				m_ready.wait(&m_mutex);
+			if (m_isCancelled)
+				break;
+			chunk = std::move(m_chunks.at(next));
+			m_chunks.erase(next);
+		}
+		pushItems(chunk.items);
+		emit progress(ranges.at(next).second - begin, end - begin);
+		if (!chunk.error.isEmpty())
+		{
+			m_error = chunk.error;
+			m_isCancelled = true;
+		}
+	}
+	QMutexLocker locker(&m_mutex);
+	while (m_doneCount < submitted)
+		m_ready.wait(&m_mutex);
+	m_chunks.clear();
+	m_doneCount = 0;
+}
+// The range is parsed between the document's own prolog and root end tag, so DOCTYPE entities and
+// namespace declarations resolve as in a sequential read. The mapped bytes are fed in blocks as the
+// reader asks for more instead of being copied into one buffer.
+SvgLoader::Chunk SvgLoader::readChunk(const QByteArray& prolog, const QByteArray& epilog, const char* begin, const char* end) const
+{
+	TRACE_SCOPE("SvgLoader::readChunk", "io");
+	Chunk chunk;
+	QXmlStreamReader reader;
+	reader.addData(prolog);
+	const char* p = begin;
+	bool isFed = false;
+	while (!m_isCancelled)
+	{
+		if (reader.readNext() == QXmlStreamReader::StartElement)
+		{
+			ElementBase item;
+			if (parseElement(reader, item))
+				chunk.items.push_back(std::move(item));
+		}
+		else if (reader.error() == QXmlStreamReader::PrematureEndOfDocumentError && !isFed)
+		{
+			size_t length = qMin(static_cast<size_t>(end - p), FeedBlockSize);
+			isFed = length == 0;
+			reader.addData(isFed ? epilog : QByteArray::fromRawData(p, static_cast<int>(length)));
+			p += length;
+		}
+		else if (reader.atEnd())
+		{
+			break;
+		}
+	}
+	if (reader.hasError())
+		chunk.error = reader.errorString();
+	return chunk;
+}
+void SvgLoader::pushItems(std::vector<ElementBase>& items)
+{
+	if (items.empty())
+		return;
+	bool notify = false;
+	{
+		QMutexLocker locker(&m_mutex);
+		if (m_items.empty())
+			m_items.swap(items);
+		else
+			std::move(items.begin(), items.end(), std::back_inserter(m_items));
+		notify = !m_isNotified;
+		m_isNotified = true;
+	}
+	items.clear();
+	if (notify)
+		emit itemsReady();
+}
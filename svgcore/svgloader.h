@@ -0,0 +1,69 @@
+#ifndef SVGLOADER_H_
+#define SVGLOADER_H_
+
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include <QColor>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+#include <QXmlStreamReader>
+
+#include "element.h"
+
+// Parses an SVG or native (.sved) file on a worker thread. The file is memory mapped and read in
+// place; parsed items are handed over in batches through itemsReady/takeItems so they can be shown
+// while loading. Compressed .svgz files are inflated as they are read instead.
+// With more than one thread the children of the root are split into byte ranges that are parsed
+// in parallel and handed over in document order. setThreadCount(1) parses in a single pass.
+class SvgLoader : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit SvgLoader(QObject* parent = nullptr);
+	SvgLoader(const SvgLoader&) = delete;
+	SvgLoader& operator=(const SvgLoader&) = delete;
+	~SvgLoader();
+	void start(const QString& fileName);
+	bool load(const QString& fileName);
+	void setThreadCount(int count);
+	void cancel();
+	bool isRunning() const;
+	std::vector<ElementBase> takeItems();
+	QString getErrorString() const;
+	static bool parseElement(const QXmlStreamReader& reader, ElementBase& item);
+signals:
+	void pageSizeParsed(int width, int height);
+	void backGroundColorParsed(const QColor& color);
+	void itemsReady();
+	void progress(qint64 bytes, qint64 total);
+	void finished(bool ok);
+private:
+	struct Chunk
+	{
+		std::vector<ElementBase> items;
+		QString error;
+	};
+	void readNative(const char* data, qint64 size);
+	void readSequential(QXmlStreamReader& reader, qint64 size, const QIODevice* source = nullptr);
+	void readParallel(const char* begin, const char* end);
+	Chunk readChunk(const QByteArray& prolog, const QByteArray& epilog, const char* begin, const char* end) const;
+	void pushItems(std::vector<ElementBase>& items);
+	QThreadPool m_pool;
+	QMutex m_mutex;
+	QWaitCondition m_ready;
+	std::vector<ElementBase> m_items;
+	std::map<int, Chunk> m_chunks;
+	bool m_isNotified;
+	int m_doneCount;
+	std::atomic<bool> m_isCancelled;
+	std::atomic<bool> m_isRunning;
+	QString m_error;
+};
+
+#endif // !SVGLOADER_H_
@@ -0,0 +1,319 @@
+#include "svgpathparser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <string>
+
+#include <QtMath>
+
+namespace
+{
+	const size_t ShortNumberLength = 32;
+	const double FlatteningStep = 2;
+	const int MaxCurveSegments = 64;
+
+	bool isDigit(const QChar* c)
+	{
+		return c->unicode() >= '0' && c->unicode() <= '9';
+	}
+
+	// Numbers are almost always short enough for the stack buffer; longer literals are still valid.
+	bool toDouble(const QChar* begin, const QChar* end, double& value)
+	{
+		if (begin != end && *begin == QLatin1Char('+'))
+			++begin;
+		size_t length = end - begin;
+		char buffer[ShortNumberLength];
+		std::string overflow;
+		char* text = buffer;
+		if (length > ShortNumberLength)
+		{
+			overflow.resize(length);
+			text = &overflow[0];
+		}
+		std::transform(begin, end, text, [](const QChar& c)
+			{
+				return c.toLatin1();
+			});
+		return std::from_chars(text, text + length, value).ec == std::errc();
+	}
+
+	double distance(const QPointF& start, const QPointF& end)
+	{
+		QPointF offset = end - start;
+		return std::sqrt(QPointF::dotProduct(offset, offset));
+	}
+
+	int segmentsFor(double length)
+	{
+		return qBound(1, static_cast<int>(std::ceil(length / FlatteningStep)), MaxCurveSegments);
+	}
+
+	void flattenCubic(QPainterPath& path, const QPointF& p0, const QPointF& p1, const QPointF& p2, const QPointF& p3)
+	{
+		int segments = segmentsFor(distance(p0, p1) + distance(p1, p2) + distance(p2, p3));
+		for (int i = 1; i < segments; ++i)
+		{
+			double t = static_cast<double>(i) / segments;
+			double s = 1 - t;
+			path.lineTo(p0 * (s * s * s) + p1 * (3 * s * s * t) + p2 * (3 * s * t * t) + p3 * (t * t * t));
+		}
+		path.lineTo(p3);
+	}
+
+	void flattenQuad(QPainterPath& path, const QPointF& p0, const QPointF& p1, const QPointF& p2)
+	{
+		int segments = segmentsFor(distance(p0, p1) + distance(p1, p2));
+		for (int i = 1; i < segments; ++i)
+		{
+			double t = static_cast<double>(i) / segments;
+			double s = 1 - t;
+			path.lineTo(p0 * (s * s) + p1 * (2 * s * t) + p2 * (t * t));
+		}
+		path.lineTo(p2);
+	}
+
+	// Endpoint to center parameterization as in the SVG implementation notes (F.6.5 and F.6.6).
+	void flattenArc(QPainterPath& path, const QPointF& p0, double rx, double ry, double angle, bool isLarge, bool isSweep, const QPointF& p1)
+	{
+		if (p0 == p1)
+			return;
+		rx = std::abs(rx);
+		ry = std::abs(ry);
+		if (rx == 0 || ry == 0)
+		{
+			path.lineTo(p1);
+			return;
+		}
+		double phi = qDegreesToRadians(angle);
+		double cosPhi = std::cos(phi);
+		double sinPhi = std::sin(phi);
+		QPointF half = (p0 - p1) / 2;
+		double x = cosPhi * half.x() + sinPhi * half.y();
+		double y = -sinPhi * half.x() + cosPhi * half.y();
+		double lambda = (x * x) / (rx * rx) + (y * y) / (ry * ry);
+		if (lambda > 1)
+		{
+			rx *= std::sqrt(lambda);
+			ry *= std::sqrt(lambda);
+		}
+		double numerator = rx * rx * ry * ry - rx * rx * y * y - ry * ry * x * x;
+		double denominator = rx * rx * y * y + ry * ry * x * x;
+		double coefficient = std::sqrt(qMax(0.0, numerator / denominator));
+		if (isLarge == isSweep)
+			coefficient = -coefficient;
+		double cx = coefficient * rx * y / ry;
+		double cy = -coefficient * ry * x / rx;
+		QPointF center(cosPhi * cx - sinPhi * cy + (p0.x() + p1.x()) / 2, sinPhi * cx + cosPhi * cy + (p0.y() + p1.y()) / 2);
+		double start = std::atan2((y - cy) / ry, (x - cx) / rx);
+		double sweep = std::atan2((-y - cy) / ry, (-x - cx) / rx) - start;
+		if (!isSweep && sweep > 0)
+			sweep -= 2 * M_PI;
+		else if (isSweep && sweep < 0)
+			sweep += 2 * M_PI;
+		int segments = segmentsFor(std::abs(sweep) * qMax(rx, ry));
+		for (int i = 1; i < segments; ++i)
+		{
+			double theta = start + sweep * i / segments;
+			double ex = rx * std::cos(theta);
+			double ey = ry * std::sin(theta);
+			path.lineTo(center + QPointF(cosPhi * ex - sinPhi * ey, sinPhi * ex + cosPhi * ey));
+		}
+		path.lineTo(p1);
+	}
+}
+
+SvgPathParser::SvgPathParser(const QStringRef& data)
+	: SvgPathParser(data.constData(), data.constData() + data.size())
+{
+}
+SvgPathParser::SvgPathParser(const QChar* begin, const QChar* end)
+	: m_begin(begin)
+	, m_current(begin)
+	, m_end(end)
+{
+}
+bool SvgPathParser::parse(QPainterPath& path)
+{
+	QPointF current;
+	QPointF start;
+	// The last control point, reflected by S and T when they follow a curve of their kind.
+	QPointF control;
+	char previous = 0;
+	char command = 0;
+	skipSeparators();
+	while (m_current != m_end)
+	{
+		if (m_current->isLetter())
+			command = m_current++->toLatin1();
+		else if (command == 0)
+			return false;
+		bool isRelative = command >= 'a' && command <= 'z';
+		QPointF origin = isRelative ? current : QPointF();
+		QPointF point;
+		QPointF first;
+		QPointF second;
+		double value = 0;
+		switch (command)
+		{
+		case 'M':
+		case 'm':
+			if (!readPoint(point))
+				return false;
+			current = origin + point;
+			start = current;
+			path.moveTo(current);
+			command = isRelative ? 'l' : 'L';
+			break;
+		case 'L':
+		case 'l':
+			if (!readPoint(point))
+				return false;
+			current = origin + point;
+			path.lineTo(current);
+			break;
+		case 'H':
+		case 'h':
+			if (!readNumber(value))
+				return false;
+			current.setX(isRelative ? current.x() + value : value);
+			path.lineTo(current);
+			break;
+		case 'V':
+		case 'v':
+			if (!readNumber(value))
+				return false;
+			current.setY(isRelative ? current.y() + value : value);
+			path.lineTo(current);
+			break;
+		case 'C':
+		case 'c':
+			if (!readPoint(first) || !readPoint(second) || !readPoint(point))
+				return false;
+			control = origin + second;
+			flattenCubic(path, current, origin + first, control, origin + point);
+			current = origin + point;
+			break;
+		case 'S':
+		case 's':
+			if (!readPoint(second) || !readPoint(point))
+				return false;
+			first = previous == 'C' || previous == 'S' ? current * 2 - control : current;
+			control = origin + second;
+			flattenCubic(path, current, first, control, origin + point);
+			current = origin + point;
+			break;
+		case 'Q':
+		case 'q':
+			if (!readPoint(first) || !readPoint(point))
+				return false;
+			control = origin + first;
+			flattenQuad(path, current, control, origin + point);
+			current = origin + point;
+			break;
+		case 'T':
+		case 't':
+			if (!readPoint(point))
+				return false;
+			control = previous == 'Q' || previous == 'T' ? current * 2 - control : current;
+			flattenQuad(path, current, control, origin + point);
+			current = origin + point;
+			break;
+		case 'A':
+		case 'a':
+		{
+			double rx = 0;
+			double ry = 0;
+			bool isLarge = false;
+			bool isSweep = false;
+			if (!readNumber(rx) || !readNumber(ry) || !readNumber(value) || !readFlag(isLarge) || !readFlag(isSweep) || !readPoint(point))
+				return false;
+			flattenArc(path, current, rx, ry, value, isLarge, isSweep, origin + point);
+			current = origin + point;
+			break;
+		}
+		case 'Z':
+		case 'z':
+			path.closeSubpath();
+			current = start;
+			command = 0;
+			break;
+		default:
+			--m_current;
+			return false;
+		}
+		previous = command == 0 ? 'Z' : QChar(command).toUpper().toLatin1();
+		skipSeparators();
+	}
+	return true;
+}
+int SvgPathParser::getErrorPosition() const
+{
+	return m_current == m_end ? -1 : static_cast<int>(m_current - m_begin);
+}
+void SvgPathParser::skipSeparators()
+{
+	while (m_current != m_end && (m_current->isSpace() || *m_current == QLatin1Char(',')))
+		++m_current;
+}
+bool SvgPathParser::readNumber(double& value)
+{
+	skipSeparators();
+	const QChar* first = m_current;
+	if (m_current != m_end && (*m_current == QLatin1Char('+') || *m_current == QLatin1Char('-')))
+		++m_current;
+	bool hasDigits = false;
+	while (m_current != m_end && isDigit(m_current))
+	{
+		hasDigits = true;
+		++m_current;
+	}
+	if (m_current != m_end && *m_current == QLatin1Char('.'))
+	{
+		++m_current;
+		while (m_current != m_end && isDigit(m_current))
+		{
+			hasDigits = true;
+			++m_current;
+		}
+	}
+	if (!hasDigits)
+	{
+		m_current = first;
+		return false;
+	}
+	if (m_current != m_end && (*m_current == QLatin1Char('e') || *m_current == QLatin1Char('E')))
+	{
+		const QChar* exponent = m_current++;
+		if (m_current != m_end && (*m_current == QLatin1Char('+') || *m_current == QLatin1Char('-')))
+			++m_current;
+		bool hasExponent = false;
+		while (m_current != m_end && isDigit(m_current))
+		{
+			hasExponent = true;
+			++m_current;
+		}
+		if (!hasExponent)
+			m_current = exponent;
+	}
+	return toDouble(first, m_current, value);
+}
+bool SvgPathParser::readPoint(QPointF& point)
+{
+	double x = 0;
+	double y = 0;
+	if (!readNumber(x) || !readNumber(y))
+		return false;
+	point = QPointF(x, y);
+	return true;
+}
+// Arc flags are a single digit and may be written without a separator after them.
+bool SvgPathParser::readFlag(bool& flag)
+{
+	skipSeparators();
+	if (m_current == m_end || (*m_current != QLatin1Char('0') && *m_current != QLatin1Char('1')))
+		return false;
+	flag = *m_current++ == QLatin1Char('1');
+	return true;
+}
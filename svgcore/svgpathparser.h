@@ -0,0 +1,31 @@
+#ifndef SVGPATHPARSER_H_
+#define SVGPATHPARSER_H_
+
+#include <QChar>
+#include <QPainterPath>
+#include <QPointF>
+#include <QStringRef>
+
+// Single-pass parser for the d attribute of <path>. It reads the attribute text in place and
+// appends to the QPainterPath as it goes. Supports every path command in absolute and relative
+// form, with any mix of spaces and commas and implicitly repeated coordinates. Paths are polylines
+// in the editor, so curves and arcs are flattened into line segments.
+// On malformed data parse returns false and the path holds what was read up to the error.
+class SvgPathParser
+{
+public:
+	explicit SvgPathParser(const QStringRef& data);
+	SvgPathParser(const QChar* begin, const QChar* end);
+	bool parse(QPainterPath& path);
+	int getErrorPosition() const;
+private:
+	void skipSeparators();
+	bool readNumber(double& value);
+	bool readPoint(QPointF& point);
+	bool readFlag(bool& flag);
+	const QChar* m_begin;
+	const QChar* m_current;
+	const QChar* m_end;
+};
+
+#endif // !SVGPATHPARSER_H_
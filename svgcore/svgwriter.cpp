@@ -0,0 +1,108 @@
+#include "svgwriter.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// Long enough for any double in fixed notation, from 1.8e308 down to the smallest denormal.
+	const size_t MaxNumberLength = 400;
+}
+
+SvgWriter::SvgWriter(QIODevice* device, size_t capacity)
+	: m_device(device)
+	, m_buffer(std::max<size_t>(capacity, 64))
+	, m_size(0)
+	, m_precision(-1)
+	, m_quantum(1)
+	, m_hasError(false)
+{
+}
+SvgWriter::~SvgWriter()
+{
+	flush();
+}
+SvgWriter& SvgWriter::operator<<(const char* text)
+{
+	write(text, std::strlen(text));
+	return *this;
+}
+SvgWriter& SvgWriter::operator<<(const std::string& text)
+{
+	write(text.data(), text.size());
+	return *this;
+}
+SvgWriter& SvgWriter::operator<<(const QString& text)
+{
+	QByteArray utf8 = text.toUtf8();
+	write(utf8.constData(), utf8.size());
+	return *this;
+}
+SvgWriter& SvgWriter::operator<<(char c)
+{
+	if (m_size == m_buffer.size())
+		flush();
+	m_buffer[m_size++] = c;
+	return *this;
+}
+SvgWriter& SvgWriter::operator<<(int value)
+{
+	char text[16];
+	std::to_chars_result result = std::to_chars(text, text + sizeof(text), value);
+	write(text, result.ptr - text);
+	return *this;
+}
+SvgWriter& SvgWriter::operator<<(double value)
+{
+	if (m_precision >= 0 && std::abs(value) < 1e15)
+		value = std::round(value * m_quantum) / m_quantum;
+	if (value == 0)
+		value = 0;
+	// Fixed notation, as not every SVG consumer reads exponents; the digits are still the shortest
+	// that read back to the same double.
+	char text[MaxNumberLength];
+	std::to_chars_result result = std::to_chars(text, text + sizeof(text), value, std::chars_format::fixed);
+	write(text, result.ptr - text);
+	return *this;
+}
+SvgWriter& SvgWriter::operator<<(const QPointF& point)
+{
+	return *this << point.x() << ',' << point.y();
+}
+void SvgWriter::setPrecision(int decimals)
+{
+	m_precision = std::min(decimals, 15);
+	m_quantum = m_precision >= 0 ? std::pow(10.0, m_precision) : 1;
+}
+int SvgWriter::getPrecision() const
+{
+	return m_precision;
+}
+bool SvgWriter::flush()
+{
+	if (m_size != 0 && !m_hasError)
+		m_hasError = m_device->write(m_buffer.data(), m_size) != static_cast<qint64>(m_size);
+	m_size = 0;
+	return !m_hasError;
+}
+bool SvgWriter::hasError() const
+{
+	return m_hasError;
+}
+void SvgWriter::write(const char* data, size_t size)
+{
+	if (m_size + size > m_buffer.size())
+	{
+		flush();
+		if (size > m_buffer.size())
+		{
+			if (!m_hasError)
+				m_hasError = m_device->write(data, size) != static_cast<qint64>(size);
+			return;
+		}
+	}
+	std::memcpy(m_buffer.data() + m_size, data, size);
+	m_size += size;
+}
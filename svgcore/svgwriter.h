@@ -0,0 +1,43 @@
+#ifndef SVGWRITER_H_
+#define SVGWRITER_H_
+
+#include <string>
+#include <vector>
+
+#include <QIODevice>
+#include <QPointF>
+#include <QString>
+
+// Buffered text sink for SVG output. Elements write straight into it and full blocks go to the
+// device, so no document-sized string is ever built.
+// Numbers are written without exponent in the shortest form that reads back to the same double,
+// independent of the locale. setPrecision(n) rounds them to n decimals first; a negative value keeps full precision.
+class SvgWriter
+{
+public:
+	explicit SvgWriter(QIODevice* device, size_t capacity = 1 << 16);
+	SvgWriter(const SvgWriter&) = delete;
+	SvgWriter& operator=(const SvgWriter&) = delete;
+	~SvgWriter();
+	SvgWriter& operator<<(const char* text);
+	SvgWriter& operator<<(const std::string& text);
+	SvgWriter& operator<<(const QString& text);
+	SvgWriter& operator<<(char c);
+	SvgWriter& operator<<(int value);
+	SvgWriter& operator<<(double value);
+	SvgWriter& operator<<(const QPointF& point);
+	void setPrecision(int decimals);
+	int getPrecision() const;
+	bool flush();
+	bool hasError() const;
+private:
+	void write(const char* data, size_t size);
+	QIODevice* m_device;
+	std::vector<char> m_buffer;
+	size_t m_size;
+	int m_precision;
+	double m_quantum;
+	bool m_hasError;
+};
+
+#endif // !SVGWRITER_H_
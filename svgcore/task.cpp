@@ -0,0 +1,10 @@
+#include "task.h"
+
+Task::Task(std::function<void()> function)
+	: m_function(std::move(function))
+{
+}
+void Task::run()
+{
+	m_function();
+}
@@ -0,0 +1,21 @@
+#ifndef TASK_H_
+#define TASK_H_
+
+#include <functional>
+
+#include <QRunnable>
+
+// Runs a function object on a QThreadPool; Qt 5.9 has no QThreadPool::start(std::function).
+class Task :public QRunnable
+{
+public:
+	explicit Task(std::function<void()> function);
+	Task(const Task&) = delete;
+	Task& operator=(const Task&) = delete;
+	~Task() = default;
+	virtual void run() override;
+private:
+	std::function<void()> m_function;
+};
+
+#endif // !TASK_H_
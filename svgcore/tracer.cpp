@@ -0,0 +1,133 @@
+#include "tracer.h"
+
+#include <algorithm>
+#include <charconv>
+
+#include <QCoreApplication>
+#include <QMutexLocker>
+
+namespace
+{
+	const size_t FlushEvents = 4096;
+
+	int currentThread()
+	{
+		static std::atomic<int> next(0);
+		thread_local int id = ++next;
+		return id;
+	}
+	void appendString(QByteArray& text, const char* value)
+	{
+		static const char Hex[] = "0123456789abcdef";
+		text.append('"');
+		for (const char* p = value; *p != 0; ++p)
+		{
+			unsigned char c = static_cast<unsigned char>(*p);
+			if (c == '"' || c == '\\')
+				text.append('\\').append(*p);
+			else if (c < 0x20)
+				text.append("\\u00").append(Hex[c >> 4]).append(Hex[c & 0xf]);
+			else
+				text.append(*p);
+		}
+		text.append('"');
+	}
+	void appendInteger(QByteArray& text, qint64 value)
+	{
+		char digits[24];
+		std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+		text.append(digits, static_cast<int>(result.ptr - digits));
+	}
+	// Writes nanoseconds as the microseconds the format expects, without going through the C locale,
+	// which may use a decimal comma.
+	void appendMicroseconds(QByteArray& text, qint64 nanoseconds)
+	{
+		appendInteger(text, nanoseconds / 1000);
+		char fraction[4] = { '.', static_cast<char>('0' + nanoseconds / 100 % 10), static_cast<char>('0' + nanoseconds / 10 % 10)
+			, static_cast<char>('0' + nanoseconds % 10) };
+		text.append(fraction, sizeof(fraction));
+	}
+}
+
+std::atomic<bool> Tracer::s_isEnabled(false);
+
+Tracer& Tracer::getInstance()
+{
+	static Tracer instance;
+	return instance;
+}
+Tracer::Tracer()
+{
+	m_clock.start();
+}
+Tracer::~Tracer()
+{
+	stop();
+}
+bool Tracer::start(const QString& fileName)
+{
+	stop();
+	QMutexLocker locker(&m_mutex);
+	m_file.setFileName(fileName);
+	if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+	QByteArray header("[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+	appendInteger(header, currentThread());
+	header.append(",\"args\":{\"name\":");
+	appendString(header, QCoreApplication::applicationName().toUtf8().constData());
+	header.append("}},\n");
+	m_file.write(header);
+	m_events.reserve(FlushEvents);
+	s_isEnabled = true;
+	return true;
+}
+bool Tracer::startFromEnvironment()
+{
+	QString fileName = QString::fromLocal8Bit(qgetenv("SVGEDITOR_TRACE"));
+	return !fileName.isEmpty() && start(fileName);
+}
+void Tracer::stop()
+{
+	QMutexLocker locker(&m_mutex);
+	if (!s_isEnabled)
+		return;
+	s_isEnabled = false;
+	flush();
+	m_file.close();
+}
+qint64 Tracer::now() const
+{
+	return m_clock.nsecsElapsed();
+}
+void Tracer::addEvent(const char* name, const char* category, qint64 begin, qint64 end)
+{
+	Event event = { name, category, begin, end, currentThread() };
+	QMutexLocker locker(&m_mutex);
+	if (!s_isEnabled)
+		return;
+	m_events.push_back(event);
+	if (m_events.size() >= FlushEvents)
+		flush();
+}
+void Tracer::flush()
+{
+	QByteArray text;
+	text.reserve(static_cast<int>(m_events.size() * 112));
+	std::for_each(m_events.begin(), m_events.end(), [&text](const Event& event)
+		{
+			text.append("{\"name\":");
+			appendString(text, event.name);
+			text.append(",\"cat\":");
+			appendString(text, event.category);
+			text.append(",\"ph\":\"X\",\"ts\":");
+			appendMicroseconds(text, event.begin);
+			text.append(",\"dur\":");
+			appendMicroseconds(text, event.end - event.begin);
+			text.append(",\"pid\":1,\"tid\":");
+			appendInteger(text, event.thread);
+			text.append("},\n");
+		});
+	m_events.clear();
+	m_file.write(text);
+	m_file.flush();
+}
@@ -0,0 +1,91 @@
+#ifndef TRACER_H_
+#define TRACER_H_
+
+#include <atomic>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QString>
+
+// Records scoped trace points as Chrome trace-event JSON (chrome://tracing, Perfetto). Tracing is off
+// until start() is called, for example from the SVGEDITOR_TRACE environment variable; while it is off
+// a TRACE_SCOPE costs one relaxed atomic load. Defining SVGEDITOR_NO_TRACE compiles them out.
+// The file is the array form without its closing bracket, which viewers accept, so a trace cut off
+// by a crash still opens.
+class Tracer
+{
+public:
+	static Tracer& getInstance();
+	~Tracer();
+	bool start(const QString& fileName);
+	bool startFromEnvironment();
+	void stop();
+	static bool isEnabled()
+	{
+		return s_isEnabled.load(std::memory_order_relaxed);
+	}
+	qint64 now() const;
+	void addEvent(const char* name, const char* category, qint64 begin, qint64 end);
+private:
+	struct Event
+	{
+		const char* name;
+		const char* category;
+		qint64 begin;
+		qint64 end;
+		int thread;
+	};
+	Tracer();
+	Tracer(const Tracer&) = delete;
+	Tracer(Tracer&&) = delete;
+	Tracer& operator=(const Tracer&) = delete;
+	Tracer& operator=(Tracer&&) = delete;
+	void flush();
+	static std::atomic<bool> s_isEnabled;
+	QElapsedTimer m_clock;
+	QMutex m_mutex;
+	QFile m_file;
+	std::vector<Event> m_events;
+};
+
+// Adds one complete event covering its own lifetime. name and category must be string literals.
+class TraceScope
+{
+public:
+	TraceScope(const char* name, const char* category)
+		: m_name(nullptr)
+	{
+		if (Tracer::isEnabled())
+		{
+			m_name = name;
+			m_category = category;
+			m_begin = Tracer::getInstance().now();
+		}
+	}
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+	~TraceScope()
+	{
+		if (m_name != nullptr)
+		{
+			Tracer& tracer = Tracer::getInstance();
+			tracer.addEvent(m_name, m_category, m_begin, tracer.now());
+		}
+	}
+private:
+	const char* m_name;
+	const char* m_category;
+	qint64 m_begin;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#ifdef SVGEDITOR_NO_TRACE
+#define TRACE_SCOPE(name, category)
+#else
+#define TRACE_SCOPE(name, category) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name, category)
+#endif
+
+#endif // !TRACER_H_
@@ -1,14 +1,28 @@
 #include "canvas.h"
 
+#include <QFontMetrics>
 #include <QMenu>
+#include <QScrollBar>
 #include <QPainter>
 #include <QPalette>
+#include <QRegion>
 #include <QShortCut>
+#include <QThread>
+#include <QtMath>
 
-#include "command.h"
+#include "canvascommand.h"
+#include "tracer.h"
+
+namespace
+{
+	const int OverlayMargin = 8;
+	const int OverlayWidth = 240;
+	const int OverlayLines = 6;
+	const QColor BandColor(0, 120, 215);
+}
 
 Canvas::Canvas(QWidget* parent = Q_NULLPTR)
-	: QWidget(parent)
+	: QAbstractScrollArea(parent)
 	, m_manager(std::make_shared<Manager>())
 	, m_isPressed(false)
 	, m_isCreating(false)
@@ -18,13 +32,27 @@ Canvas::Canvas(QWidget* parent = Q_NULLPTR)
 	, m_type(Type::None)
 	, m_edge(Edge::NoEdge)
 	, m_scale(1)
+	, m_pageSize(1600, 900)
 	, m_history(CommandHistory::getInstance())
-	, m_rubberBand(new QRubberBand(QRubberBand::Rectangle, this))
-{
-	setMouseTracking(true);
-	setFixedSize(1600, 900);
-	setAutoFillBackground(true);
+	, m_isBanding(false)
+	, m_isOverlayVisible(false)
+	, m_isInputPending(false)
+	, m_frameTime(0)
+	, m_inputLatency(0)
+{
+	viewport()->setMouseTracking(true);
+	viewport()->setAutoFillBackground(false);
+	viewport()->setAttribute(Qt::WA_OpaquePaintEvent);
 	setPalette(QPalette(QPalette::Window, Qt::white));
+	updateScrollBars();
+	connect(this, &Canvas::sizeChange, [this]
+		{
+			invalidateLayerCache();
+		});
+	connect(this, &Canvas::backGroundColorChange, [this]
+		{
+			invalidateLayerCache();
+		});
 }
 Canvas::~Canvas()
 {
@@ -33,35 +61,37 @@ void Canvas::setItemType(Type type)
 {
 	m_type = type;
 	if (m_type == Type::None)
-		setCursor(Qt::ArrowCursor);
+		viewport()->setCursor(Qt::ArrowCursor);
 }
 void Canvas::setSize(int width, int height)
 {
 	m_history.addCommand(std::make_shared<ChangeCanvasSize>(this, QSize(width, height)));
-	setFixedSize(static_cast<int>(width * m_scale), static_cast<int>(height * m_scale));
+	m_pageSize = QSize(width, height);
+	updateViewport();
 }
 void Canvas::setScale(double scale)
 {
 	if (scale != 0)
 	{
 		m_history.addCommand(std::make_shared<ChangeScale>(this, scale));
-		setFixedSize(static_cast<int>(size().width() * scale / m_scale), static_cast<int>(size().height() * scale / m_scale));
 		m_scale = scale;
-		update();
+		updateViewport();
 	}
 }
 void Canvas::setBackGroundColor(const QColor& color)
 {
 	m_history.addCommand(std::make_shared<ChangeBackGroundColor>(this, color));
 	setPalette(QPalette(QPalette::Window, color));
+	invalidateLayerCache();
+	viewport()->update();
 }
 int Canvas::getWidth() const
 {
-	return static_cast<int>(size().width() / m_scale);
+	return m_pageSize.width();
 }
 int Canvas::getHeight() const
 {
-	return static_cast<int>(size().height() / m_scale);
+	return m_pageSize.height();
 }
 double Canvas::getScale() const
 {
@@ -71,6 +101,10 @@ double& Canvas::getScaleRefer()
 {
 	return m_scale;
 }
+QSize& Canvas::getPageSizeRefer()
+{
+	return m_pageSize;
+}
 const QColor& Canvas::getBackGroundColor() const
 {
 	return palette().color(QPalette::Active, QPalette::Window);
@@ -85,28 +119,46 @@ std::shared_ptr<Manager> Canvas::getManager() const
 }
 void Canvas::reset()
 {
+	// The capture settings belong to the editor, not to the document.
+	StrokeFilter filter = m_manager->getStrokeFilter();
 	m_manager = std::make_shared<Manager>();
+	m_manager->setCaptureTolerance(filter.getTolerance());
+	m_manager->setCaptureSmoothing(filter.getSmoothing());
 	m_history.clearAll();
-	setFixedSize(700, 500);
+	m_pageSize = QSize(700, 500);
 	setPalette(QPalette(QPalette::Window, Qt::white));
 	emit backGroundColorChange();
 	emit sizeChange();
 	emit selectedItemChanged(nullptr);
-	update();
+	updateViewport();
 }
-std::string Canvas::toSvgText() const
+void Canvas::writeSvg(SvgWriter& writer) const
 {
-	if (getBackGroundColor() != Qt::white)
-	{
-		std::string backgroud = "\t<rect width=\"100%\" height=\"100%\" fill = \"" + getBackGroundColor().name().toStdString() + "\"/>\n";
-		return "<svg width=\"" + std::to_string(getWidth()) + "\" height=\"" + std::to_string(getHeight())
-			+ "\" xmlns=\"http://www.w3.org/2000/svg\">\n" + backgroud + m_manager->toSvgElements() + "</svg>";
-	}
-	else
-	{
-		return "<svg width=\"" + std::to_string(getWidth()) + "\" height=\"" + std::to_string(getHeight())
-			+ "\" xmlns=\"http://www.w3.org/2000/svg\">\n" + m_manager->toSvgElements() + "</svg>";
-	}
+	m_manager->writeSvg(writer, m_pageSize, getBackGroundColor());
+}
+void Canvas::appendItems(const std::vector<ElementBase>& items)
+{
+	// Batches are handed over by loader threads and must be queued to the GUI thread.
+	Q_ASSERT(QThread::currentThread() == thread());
+	m_manager->addItems(items);
+	updateDamage();
+}
+void Canvas::updateViewport()
+{
+	updateScrollBars();
+	invalidateLayerCache();
+	viewport()->update();
+}
+void Canvas::setOverlayVisible(bool visible)
+{
+	m_isOverlayVisible = visible;
+	m_isInputPending = false;
+	m_inputLatency = 0;
+	viewport()->update();
+}
+bool Canvas::isOverlayVisible() const
+{
+	return m_isOverlayVisible;
 }
 
 
@@ -155,34 +207,60 @@ void Canvas::downMost()
 void Canvas::undo()
 {
 	m_history.undo();
+	m_manager->compactIfNeeded();
+	invalidateLayerCache();
+	viewport()->update();
 }
 void Canvas::redo()
 {
 	m_history.redo();
+	m_manager->compactIfNeeded();
+	invalidateLayerCache();
+	viewport()->update();
 }
 
 void Canvas::mousePressEvent(QMouseEvent* event)
 {
+	TRACE_SCOPE("Canvas::mousePressEvent", "input");
+	markInput();
 	if (event->button() == Qt::LeftButton)
-		leftButtonPressed(event->localPos() / m_scale);
-	update();
+		leftButtonPressed(mapToDocument(event->localPos()));
+	if (m_isCreating || m_isResizing || m_isMoving)
+	{
+		invalidateLayerCache();
+		m_manager->beginLiveEdit();
+	}
+	updateDamage();
 	emit selectedItemChanged(m_manager->getSelectedItem());
-	return QWidget::mousePressEvent(event);
+	return QAbstractScrollArea::mousePressEvent(event);
 }
 void Canvas::mouseMoveEvent(QMouseEvent* event)
 {
-	mouseMoving(event->localPos() / m_scale);
-	update();
-	return QWidget::mouseMoveEvent(event);
+	TRACE_SCOPE("Canvas::mouseMoveEvent", "input");
+	if (m_isPressed)
+		markInput();
+	mouseMoving(mapToDocument(event->localPos()));
+	updateDamage();
+	return QAbstractScrollArea::mouseMoveEvent(event);
 }
 void Canvas::mouseReleaseEvent(QMouseEvent* event)
 {
+	TRACE_SCOPE("Canvas::mouseReleaseEvent", "input");
+	// A press that damaged nothing is never painted; do not let it time the next unrelated frame.
+	m_isInputPending = false;
 	m_isPressed = false;
 	m_isCreating = false;
 	m_isResizing = false;
 	m_isMoving = false;
-	m_rubberBand->hide();
-	return QWidget::mouseReleaseEvent(event);
+	if (m_isBanding)
+	{
+		m_isBanding = false;
+		viewport()->update(mapToDevice(m_bandRect).toAlignedRect().adjusted(-1, -1, 1, 1));
+	}
+	m_manager->endLiveEdit();
+	invalidateLayerCache();
+	updateDamage();
+	return QAbstractScrollArea::mouseReleaseEvent(event);
 }
 void Canvas::leftButtonPressed(const QPointF& pos)
 {
@@ -197,8 +275,8 @@ void Canvas::leftButtonPressed(const QPointF& pos)
 	{
 		m_manager->cancelSelected();
 		m_moveStartPos = pos;
-		m_rubberBand->setGeometry(QRect((m_moveStartPos * m_scale).toPoint(), QSize()));
-		m_rubberBand->show();
+		m_isBanding = true;
+		m_bandRect = QRectF(pos, QSizeF(0, 0));
 	}
 	else if (!m_manager->isAnyOneSelected() || !m_manager->isOnlyOneSelected())
 	{
@@ -232,7 +310,7 @@ void Canvas::mouseMoving(const QPointF& pos)
 		}
 		else
 		{
-			setCursor(Qt::CrossCursor);
+			viewport()->setCursor(Qt::CrossCursor);
 		}
 	}
 	else if (m_isCreating)
@@ -248,30 +326,83 @@ void Canvas::mouseMoving(const QPointF& pos)
 		m_manager->moveItem(m_moveStartPos, pos);
 		m_moveStartPos = pos;
 	}
-	else if (m_rubberBand->isVisible())
+	else if (m_isBanding)
 	{
-		m_rubberBand->setGeometry(QRect((m_moveStartPos * m_scale).toPoint(), (pos * m_scale).toPoint()).normalized());
-		m_manager->selectItems(QRectF(m_moveStartPos, pos));
+		QRectF band = QRectF(m_moveStartPos, pos).normalized();
+		m_manager->selectItems(m_bandRect, band);
+		updateBand(m_bandRect, band);
+		m_bandRect = band;
 	}
 }
 void Canvas::paintEvent(QPaintEvent* event)
 {
-	QPainter painter(this);
+	TRACE_SCOPE("Canvas::paintEvent", "paint");
+	QElapsedTimer timer;
+	timer.start();
+	m_manager->takePaintStats();
+	QPainter painter(viewport());
+	QRect exposed = event->rect();
+	// The overlay repaints itself after every frame; those repaints are not frames of their own.
+	bool isOverlayOnly = m_isOverlayVisible && getOverlayRect().contains(exposed);
+	QRectF page = getPageRect();
+	QRectF area = QRectF(exposed).intersected(page);
+	area = QRectF(mapToDocument(area.topLeft()), mapToDocument(area.bottomRight()));
+	if (m_manager->isLiveEditing())
+	{
+		if (m_belowLayer.isNull())
+			buildLayerCache();
+		painter.drawImage(exposed, m_belowLayer, getLayerSource(exposed));
+	}
+	else
+	{
+		paintBackground(&painter, exposed);
+	}
+	painter.save();
+	painter.setClipRect(page);
+	painter.translate(getOrigin());
 	painter.scale(m_scale, m_scale);
-	m_manager->paint(&painter);
+	m_manager->paint(&painter, area, m_manager->isLiveEditing() ? Layer::Live : Layer::All);
+	painter.restore();
+	if (m_manager->isLiveEditing())
+		painter.drawImage(exposed, m_aboveLayer, getLayerSource(exposed));
+	if (m_isBanding)
+	{
+		QColor fill = BandColor;
+		fill.setAlpha(48);
+		painter.setPen(BandColor);
+		painter.setBrush(fill);
+		painter.drawRect(mapToDevice(m_bandRect));
+	}
+	if (!m_isOverlayVisible)
+		return;
+	if (!isOverlayOnly)
+	{
+		m_frameTime = timer.nsecsElapsed();
+		m_paintStats = m_manager->takePaintStats();
+		if (m_isInputPending)
+		{
+			m_inputLatency = m_inputTimer.nsecsElapsed();
+			m_isInputPending = false;
+		}
+		viewport()->update(getOverlayRect());
+	}
+	paintOverlay(&painter);
 }
 void Canvas::contextMenuEvent(QContextMenuEvent* event)
 {
+	m_manager->endLiveEdit();
+	invalidateLayerCache();
+	updateDamage();
 	if (m_type == Type::None)
 		setRightButtonMenu(event);
 	else
 		emit toTypeNone();
-	update();
-	return QWidget::contextMenuEvent(event);
+	viewport()->update();
+	return QAbstractScrollArea::contextMenuEvent(event);
 }
 void Canvas::setRightButtonMenu(QContextMenuEvent* event)
 {
-	QPointF pos(event->pos().x() / m_scale, event->pos().y() / m_scale);
+	QPointF pos = mapToDocument(event->pos());
 	QMenu menu;
 	QAction* selectAll = menu.addAction(QString::fromLocal8Bit("ȫѡ"));
 	connect(selectAll, &QAction::triggered, this, &Canvas::selectAll);
@@ -350,7 +481,7 @@ void Canvas::setRightButtonMenu(QContextMenuEvent* event)
 		replace->setEnabled(false);
 	}
 	emit selectedItemChanged(m_manager->getSelectedItem());
-	update();
+	viewport()->update();
 	menu.exec(event->globalPos());
 }
 void Canvas::changeCursor(Edge edge)
@@ -358,33 +489,178 @@ void Canvas::changeCursor(Edge edge)
 	switch (edge)
 	{
 	case Edge::NoEdge:
-		setCursor(Qt::ArrowCursor);
+		viewport()->setCursor(Qt::ArrowCursor);
 		break;
 	case Edge::LeftEdge:
-		setCursor(Qt::SizeHorCursor);
+		viewport()->setCursor(Qt::SizeHorCursor);
 		break;
 	case Edge::TopLeft:
-		setCursor(Qt::SizeFDiagCursor);
+		viewport()->setCursor(Qt::SizeFDiagCursor);
 		break;
 	case Edge::TopEdge:
-		setCursor(Qt::SizeVerCursor);
+		viewport()->setCursor(Qt::SizeVerCursor);
 		break;
 	case Edge::TopRight:
-		setCursor(Qt::SizeBDiagCursor);
+		viewport()->setCursor(Qt::SizeBDiagCursor);
 		break;
 	case Edge::RightEdge:
-		setCursor(Qt::SizeHorCursor);
+		viewport()->setCursor(Qt::SizeHorCursor);
 		break;
 	case Edge::BottomRight:
-		setCursor(Qt::SizeFDiagCursor);
+		viewport()->setCursor(Qt::SizeFDiagCursor);
 		break;
 	case Edge::BottomEdge:
-		setCursor(Qt::SizeVerCursor);
+		viewport()->setCursor(Qt::SizeVerCursor);
 		break;
 	case Edge::BottomLeft:
-		setCursor(Qt::SizeBDiagCursor);
+		viewport()->setCursor(Qt::SizeBDiagCursor);
 		break;
 	default:
 		break;
 	}
+}
+void Canvas::updateDamage()
+{
+	// Manager already folds a long damage list into its union, so every rect is repainted as is.
+	std::vector<QRectF> damage = m_manager->takeDamage();
+	QRegion region;
+	std::for_each(damage.begin(), damage.end(), [this, &region](const QRectF& rect)
+		{
+			region += mapToDevice(rect).toAlignedRect().adjusted(-1, -1, 1, 1);
+		});
+	if (!region.isEmpty())
+		viewport()->update(region);
+}
+// Repaints only what the band uncovered or newly covers, plus both outlines, instead of the whole band.
+void Canvas::updateBand(const QRectF& from, const QRectF& to)
+{
+	QRect before = mapToDevice(from).toAlignedRect().adjusted(-1, -1, 1, 1);
+	QRect after = mapToDevice(to).toAlignedRect().adjusted(-1, -1, 1, 1);
+	QRegion region = QRegion(before).xored(QRegion(after));
+	region += QRegion(before).subtracted(QRegion(before.adjusted(2, 2, -2, -2)));
+	region += QRegion(after).subtracted(QRegion(after.adjusted(2, 2, -2, -2)));
+	viewport()->update(region);
+}
+void Canvas::buildLayerCache()
+{
+	QRectF page = getPageRect();
+	QRectF area = QRectF(viewport()->rect()).intersected(page);
+	area = QRectF(mapToDocument(area.topLeft()), mapToDocument(area.bottomRight()));
+	// Rendered at device resolution so that the canvas does not turn blurry on HiDPI screens while dragging.
+	double ratio = devicePixelRatioF();
+	QSize size(qCeil(viewport()->width() * ratio), qCeil(viewport()->height() * ratio));
+	m_belowLayer = QImage(size, QImage::Format_ARGB32_Premultiplied);
+	m_belowLayer.setDevicePixelRatio(ratio);
+	m_aboveLayer = QImage(size, QImage::Format_ARGB32_Premultiplied);
+	m_aboveLayer.setDevicePixelRatio(ratio);
+	m_aboveLayer.fill(Qt::transparent);
+	QPainter below(&m_belowLayer);
+	paintBackground(&below, viewport()->rect());
+	below.setClipRect(page);
+	below.translate(getOrigin());
+	below.scale(m_scale, m_scale);
+	m_manager->paint(&below, area, Layer::Below);
+	QPainter above(&m_aboveLayer);
+	above.setClipRect(page);
+	above.translate(getOrigin());
+	above.scale(m_scale, m_scale);
+	m_manager->paint(&above, area, Layer::Above);
+}
+// The pixels of the layer images behind a viewport rect.
+QRectF Canvas::getLayerSource(const QRect& rect) const
+{
+	double ratio = m_belowLayer.devicePixelRatio();
+	return QRectF(rect.x() * ratio, rect.y() * ratio, rect.width() * ratio, rect.height() * ratio);
+}
+void Canvas::invalidateLayerCache()
+{
+	m_belowLayer = QImage();
+	m_aboveLayer = QImage();
+}
+void Canvas::markInput()
+{
+	if (!m_isOverlayVisible || m_isInputPending)
+		return;
+	m_inputTimer.start();
+	m_isInputPending = true;
+}
+QRect Canvas::getOverlayRect() const
+{
+	QFontMetrics metrics(viewport()->font());
+	return QRect(OverlayMargin, OverlayMargin, OverlayWidth, metrics.lineSpacing() * OverlayLines + OverlayMargin);
+}
+void Canvas::paintOverlay(QPainter* painter)
+{
+	size_t total = m_manager->getItems().size();
+	size_t live = m_manager->getLiveCount();
+	double perItem = m_paintStats.drawn == 0 ? 0 : m_paintStats.nsecs / 1e3 / m_paintStats.drawn;
+	QStringList lines;
+	lines << QString::fromLocal8Bit("֡ʱ: %1 ms").arg(m_frameTime / 1e6, 0, 'f', 2)
+		<< QString::fromLocal8Bit("/ÿͼԪ: %1 us").arg(perItem, 0, 'f', 2)
+		<< QString::fromLocal8Bit("/޳: %1 / %2 ( %3)").arg(m_paintStats.drawn).arg(m_paintStats.culled).arg(m_paintStats.simplified)
+		<< QString::fromLocal8Bit("Ч/λ: %1 / %2").arg(live).arg(total - live)
+		<< QString::fromLocal8Bit("ʷ: %1 , %2 MB").arg(m_history.getUndoDepth()).arg(m_history.getMemoryUsage() / 1048576.0, 0, 'f', 2)
+		<< QString::fromLocal8Bit("뵽ӳ: %1 ms").arg(m_inputLatency / 1e6, 0, 'f', 2);
+	QRect rect = getOverlayRect();
+	painter->save();
+	painter->setRenderHint(QPainter::Antialiasing, false);
+	painter->fillRect(rect, QColor(0, 0, 0, 160));
+	painter->setPen(Qt::white);
+	painter->drawText(rect.adjusted(OverlayMargin / 2, OverlayMargin / 2, 0, 0), Qt::AlignLeft | Qt::AlignTop, lines.join('\n'));
+	painter->restore();
+}
+void Canvas::resizeEvent(QResizeEvent* event)
+{
+	updateScrollBars();
+	invalidateLayerCache();
+	return QAbstractScrollArea::resizeEvent(event);
+}
+// Moves the painted pixels and repaints only the strip scrolled into view. The layer cache and the
+// overlay are tied to the viewport, so the cache is rebuilt and the overlay is painted again in place.
+void Canvas::scrollContentsBy(int dx, int dy)
+{
+	invalidateLayerCache();
+	viewport()->scroll(dx, dy);
+	if (m_isOverlayVisible)
+	{
+		viewport()->update(getOverlayRect());
+		viewport()->update(getOverlayRect().translated(dx, dy));
+	}
+}
+void Canvas::updateScrollBars()
+{
+	QSize page(static_cast<int>(m_pageSize.width() * m_scale), static_cast<int>(m_pageSize.height() * m_scale));
+	QSize view = viewport()->size();
+	horizontalScrollBar()->setPageStep(view.width());
+	horizontalScrollBar()->setSingleStep(20);
+	horizontalScrollBar()->setRange(0, qMax(0, page.width() - view.width()));
+	verticalScrollBar()->setPageStep(view.height());
+	verticalScrollBar()->setSingleStep(20);
+	verticalScrollBar()->setRange(0, qMax(0, page.height() - view.height()));
+}
+QPointF Canvas::getOrigin() const
+{
+	double width = m_pageSize.width() * m_scale;
+	double height = m_pageSize.height() * m_scale;
+	QSize view = viewport()->size();
+	double x = width < view.width() ? (view.width() - width) / 2 : -horizontalScrollBar()->value();
+	double y = height < view.height() ? (view.height() - height) / 2 : -verticalScrollBar()->value();
+	return QPointF(x, y);
+}
+QRectF Canvas::getPageRect() const
+{
+	return QRectF(getOrigin(), QSizeF(m_pageSize.width() * m_scale, m_pageSize.height() * m_scale));
+}
+QPointF Canvas::mapToDocument(const QPointF& pos) const
+{
+	return (pos - getOrigin()) / m_scale;
+}
+QRectF Canvas::mapToDevice(const QRectF& rect) const
+{
+	return QRectF(rect.topLeft() * m_scale + getOrigin(), QSizeF(rect.width() * m_scale, rect.height() * m_scale));
+}
+void Canvas::paintBackground(QPainter* painter, const QRect& rect)
+{
+	painter->fillRect(rect, palette().color(QPalette::Dark));
+	painter->fillRect(getPageRect().intersected(QRectF(rect)), getBackGroundColor());
 }
\ No newline at end of file
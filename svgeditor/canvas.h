@@ -2,20 +2,25 @@
 #define CANVAS_H_
 
 #include <memory>
+#include <vector>
 
 #include <QColor>
 #include <QContextMenuEvent>
+#include <QElapsedTimer>
+#include <QImage>
 #include <QMouseEvent>
 #include <QPaintEvent>
 #include <QPointF>
-#include <QRubberBand>
-#include <QWidget>
+#include <QResizeEvent>
+#include <QSize>
+#include <QtWidgets/QAbstractScrollArea>
 
 #include "commandhistory.h"
 #include "element.h"
 #include "manager.h"
+#include "svgwriter.h"
 
-class Canvas :public QWidget
+class Canvas :public QAbstractScrollArea
 {
 	Q_OBJECT
 public:
@@ -29,11 +34,16 @@ public:
 	int getHeight() const;
 	double getScale() const;
 	double& getScaleRefer();
+	QSize& getPageSizeRefer();
 	const QColor& getBackGroundColor() const;
 	std::shared_ptr<Element> getSelectedItem() const;
 	std::shared_ptr<Manager> getManager() const;
 	void reset();
-	std::string toSvgText() const;
+	void writeSvg(SvgWriter& writer) const;
+	void appendItems(const std::vector<ElementBase>& items);
+	void updateViewport();
+	void setOverlayVisible(bool visible);
+	bool isOverlayVisible() const;
 public slots:
 	void selectAll();
 	void copy(const QPointF& pos);
@@ -58,10 +68,26 @@ protected:
 	virtual void mouseReleaseEvent(QMouseEvent* event) override;
 	virtual void paintEvent(QPaintEvent* event) override;
 	virtual void contextMenuEvent(QContextMenuEvent* event) override;
+	virtual void resizeEvent(QResizeEvent* event) override;
+	virtual void scrollContentsBy(int dx, int dy) override;
 	void leftButtonPressed(const QPointF& pos);
 	void mouseMoving(const QPointF& pos);
 	void setRightButtonMenu(QContextMenuEvent* event);
 	void changeCursor(Edge edge);
+	void updateDamage();
+	void updateBand(const QRectF& from, const QRectF& to);
+	void updateScrollBars();
+	QPointF getOrigin() const;
+	QRectF getPageRect() const;
+	QPointF mapToDocument(const QPointF& pos) const;
+	QRectF mapToDevice(const QRectF& rect) const;
+	void paintBackground(QPainter* painter, const QRect& rect);
+	void buildLayerCache();
+	QRectF getLayerSource(const QRect& rect) const;
+	void invalidateLayerCache();
+	void markInput();
+	QRect getOverlayRect() const;
+	void paintOverlay(QPainter* painter);
 private:
 	std::shared_ptr<Manager> m_manager;
 	bool m_isPressed;
@@ -72,8 +98,18 @@ private:
 	Type m_type;
 	Edge m_edge;
 	double m_scale;
+	QSize m_pageSize;
 	CommandHistory& m_history;
-	QRubberBand* m_rubberBand;
+	bool m_isBanding;
+	QRectF m_bandRect;
+	QImage m_belowLayer;
+	QImage m_aboveLayer;
+	bool m_isOverlayVisible;
+	bool m_isInputPending;
+	QElapsedTimer m_inputTimer;
+	qint64 m_frameTime;
+	qint64 m_inputLatency;
+	PaintStats m_paintStats;
 };
 
 #endif // !CANVAS_H_
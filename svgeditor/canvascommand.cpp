@@ -0,0 +1,57 @@
+#include "canvascommand.h"
+
+#include "canvas.h"
+
+ChangeCanvasSize::ChangeCanvasSize(Canvas* canvas, const QSize& target)
+	: m_canvas(canvas)
+	, m_backup(canvas->getWidth(), canvas->getHeight())
+	, m_target(target)
+{
+}
+void ChangeCanvasSize::redo()
+{
+	m_canvas->getPageSizeRefer() = m_target;
+	m_canvas->updateViewport();
+	emit m_canvas->sizeChange();
+}
+void ChangeCanvasSize::undo()
+{
+	m_canvas->getPageSizeRefer() = m_backup;
+	m_canvas->updateViewport();
+	emit m_canvas->sizeChange();
+}
+
+ChangeScale::ChangeScale(Canvas* canvas, double target) :m_canvas(canvas), m_backup(m_canvas->getScale()), m_target(target)
+{
+}
+void ChangeScale::redo()
+{
+	m_canvas->getScaleRefer() = m_target;
+	emit m_canvas->sizeChange();
+	m_canvas->updateViewport();
+}
+void ChangeScale::undo()
+{
+	m_canvas->getScaleRefer() = m_backup;
+	emit m_canvas->sizeChange();
+	m_canvas->updateViewport();
+}
+
+ChangeBackGroundColor::ChangeBackGroundColor(Canvas* canvas, const QColor& target)
+	: m_canvas(canvas)
+	, m_backup(canvas->getBackGroundColor())
+	, m_target(target)
+{
+}
+void ChangeBackGroundColor::redo()
+{
+	m_canvas->setPalette(m_target);
+	emit m_canvas->backGroundColorChange();
+	m_canvas->viewport()->update();
+}
+void ChangeBackGroundColor::undo()
+{
+	m_canvas->setPalette(m_backup);
+	emit m_canvas->backGroundColorChange();
+	m_canvas->viewport()->update();
+}
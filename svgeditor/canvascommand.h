@@ -0,0 +1,65 @@
+#ifndef CANVASCOMMAND_H_
+#define CANVASCOMMAND_H_
+
+#include <QSize>
+#include <QColor>
+
+#include "command.h"
+
+class Canvas;
+
+class ChangeCanvasSize :public Command
+{
+public:
+	ChangeCanvasSize() = default;
+	ChangeCanvasSize(Canvas* canvas, const QSize& target);
+	ChangeCanvasSize(const ChangeCanvasSize&) = default;
+	ChangeCanvasSize(ChangeCanvasSize&&) = default;
+	ChangeCanvasSize& operator=(const ChangeCanvasSize&) = default;
+	ChangeCanvasSize& operator=(ChangeCanvasSize&&) = default;
+	~ChangeCanvasSize() = default;
+	virtual void redo() override;
+	virtual void undo() override;
+private:
+	Canvas* m_canvas;
+	QSize m_backup;
+	QSize m_target;
+};
+
+class ChangeScale :public Command
+{
+public:
+	ChangeScale() = default;
+	ChangeScale(Canvas * canvas, double target);
+	ChangeScale(const ChangeScale&) = default;
+	ChangeScale(ChangeScale&&) = default;
+	ChangeScale& operator=(const ChangeScale&) = default;
+	ChangeScale& operator=(ChangeScale&&) = default;
+	~ChangeScale() = default;
+	virtual void redo() override;
+	virtual void undo() override;
+private:
+	Canvas* m_canvas;
+	double m_backup;
+	double m_target;
+};
+
+class ChangeBackGroundColor :public Command
+{
+public:
+	ChangeBackGroundColor() = default;
+	ChangeBackGroundColor(Canvas * canvas, const QColor& target);
+	ChangeBackGroundColor(const ChangeBackGroundColor&) = default;
+	ChangeBackGroundColor(ChangeBackGroundColor&&) = default;
+	ChangeBackGroundColor& operator=(const ChangeBackGroundColor&) = default;
+	ChangeBackGroundColor& operator=(ChangeBackGroundColor&&) = default;
+	~ChangeBackGroundColor() = default;
+	virtual void redo() override;
+	virtual void undo() override;
+private:
+	Canvas* m_canvas;
+	QColor m_backup;
+	QColor m_target;
+};
+
+#endif // !CANVASCOMMAND_H_
@@ -1,9 +1,12 @@
 #include "svgeditor.h"
 #include <QtWidgets/QApplication>
 
+#include "tracer.h"
+
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+    Tracer::getInstance().startFromEnvironment();
     SvgEditor w;
     w.show();
     return a.exec();
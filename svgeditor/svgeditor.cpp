@@ -7,25 +7,26 @@
 #include <QKeyEvent>
 #include <QLabel>
 #include <QLineEdit>
-#include <QPixmap>
+#include <QMessageBox>
 #include <QPushButton>
-#include <QScrollArea>
-#include <QTextStream>
+#include <QSaveFile>
 #include <QToolButton>
-#include <QXmlStreamReader>
 
 #include "canvas.h"
 #include "element.h"
+#include "gzipdevice.h"
 #include "manager.h"
+#include "nativeformat.h"
+#include "pngexporter.h"
+#include "svgwriter.h"
+#include "tracer.h"
 
 SvgEditor::SvgEditor(QWidget* parent)
-	: QMainWindow(parent), m_canvas(new Canvas(this))
+	: QMainWindow(parent), m_canvas(new Canvas(this)), m_loader(nullptr), m_saveAction(nullptr), m_exportAction(nullptr)
 {
 	ui.setupUi(this);
 	QHBoxLayout* hlayout = new QHBoxLayout(ui.centralWidget);
-	QScrollArea* scroll = new QScrollArea(ui.centralWidget);
-	scroll->setWidget(m_canvas);
-	hlayout->addWidget(scroll);
+	hlayout->addWidget(m_canvas);
 	setLeftToobar();
 	setTopMenuBar();
 	hlayout->addWidget(getDatePanel());
@@ -79,12 +80,40 @@ void SvgEditor::setTopMenuBar()
 	QAction* openfile = menu->addAction(QString::fromLocal8Bit("SVG"));
 	connect(openfile, &QAction::triggered, this, &SvgEditor::openFile);
 	openfile->setShortcut(Qt::CTRL + Qt::Key_O);
-	QAction* savefile = menu->addAction(QString::fromLocal8Bit(""));
-	connect(savefile, &QAction::triggered, this, &SvgEditor::saveFile);
-	savefile->setShortcut(Qt::CTRL + Qt::Key_S);
-	QAction* topng = menu->addAction(QString::fromLocal8Bit("PNG"));
-	connect(topng, &QAction::triggered, this, &SvgEditor::saveFileToPng);
-	topng->setShortcut(Qt::CTRL + Qt::Key_E);
+	m_saveAction = menu->addAction(QString::fromLocal8Bit(""));
+	connect(m_saveAction, &QAction::triggered, this, &SvgEditor::saveFile);
+	m_saveAction->setShortcut(Qt::CTRL + Qt::Key_S);
+	m_exportAction = menu->addAction(QString::fromLocal8Bit("PNG"));
+	connect(m_exportAction, &QAction::triggered, this, &SvgEditor::saveFileToPng);
+	m_exportAction->setShortcut(Qt::CTRL + Qt::Key_E);
+
+	QMenu* tool = ui.menuBar->addMenu(QString::fromLocal8Bit(""));
+	QAction* trace = tool->addAction(QString::fromLocal8Bit("ܸ"));
+	trace->setCheckable(true);
+	trace->setChecked(Tracer::isEnabled());
+	connect(trace, &QAction::toggled, [trace, this](bool checked)
+		{
+			Tracer& tracer = Tracer::getInstance();
+			if (!checked)
+			{
+				tracer.stop();
+				return;
+			}
+			if (Tracer::isEnabled())
+				return;
+			QString fileName = QFileDialog::getSaveFileName(this
+				, QString::fromLocal8Bit("ܸ")
+				, QDir::currentPath()
+				, "(*.json)");
+			if (fileName.isEmpty() || !tracer.start(fileName))
+				trace->setChecked(false);
+		});
+	QAction* overlay = tool->addAction(QString::fromLocal8Bit(""));
+	overlay->setCheckable(true);
+	connect(overlay, &QAction::toggled, [this](bool checked)
+		{
+			m_canvas->setOverlayVisible(checked);
+		});
 }
 QWidget* SvgEditor::getDatePanel()
 {
@@ -175,6 +204,36 @@ QWidget* SvgEditor::getDatePanel()
 					backgroundColor->addWidget(colorName);
 					backgroundColor->addWidget(colorButton);
 					canvasLayout->addLayout(backgroundColor, 1, 1);
+
+					QVBoxLayout* tolerance = new QVBoxLayout(canvasEdit);
+					QLabel* toleranceName = new QLabel(QString::fromLocal8Bit("ݲ"), canvasEdit);
+					toleranceName->setFixedHeight(30);
+					QLineEdit* toleranceEdit = new QLineEdit(canvasEdit);
+					toleranceEdit->installEventFilter(this);
+					toleranceEdit->setText(QString::number(m_canvas->getManager()->getStrokeFilter().getTolerance()));
+					connect(toleranceEdit, &QLineEdit::editingFinished, [this, toleranceEdit]
+						{
+							m_canvas->getManager()->setCaptureTolerance(toleranceEdit->text().toDouble());
+							toleranceEdit->setText(QString::number(m_canvas->getManager()->getStrokeFilter().getTolerance()));
+						});
+					tolerance->addWidget(toleranceName);
+					tolerance->addWidget(toleranceEdit);
+					canvasLayout->addLayout(tolerance, 2, 0);
+
+					QVBoxLayout* smoothing = new QVBoxLayout(canvasEdit);
+					QLabel* smoothingName = new QLabel(QString::fromLocal8Bit("ƽ"), canvasEdit);
+					smoothingName->setFixedHeight(30);
+					QLineEdit* smoothingEdit = new QLineEdit(canvasEdit);
+					smoothingEdit->installEventFilter(this);
+					smoothingEdit->setText(QString::number(m_canvas->getManager()->getStrokeFilter().getSmoothing() * 100));
+					connect(smoothingEdit, &QLineEdit::editingFinished, [this, smoothingEdit]
+						{
+							m_canvas->getManager()->setCaptureSmoothing(smoothingEdit->text().toDouble() / 100);
+							smoothingEdit->setText(QString::number(m_canvas->getManager()->getStrokeFilter().getSmoothing() * 100));
+						});
+					smoothing->addWidget(smoothingName);
+					smoothing->addWidget(smoothingEdit);
+					canvasLayout->addLayout(smoothing, 2, 1);
 	}
 	dataLayout->addWidget(canvasEdit);
 
@@ -346,6 +405,11 @@ QWidget* SvgEditor::getDatePanel()
 }
 void SvgEditor::newFile()
 {
+	if (m_loader != nullptr)
+	{
+		m_loader->cancel();
+		setLoader(nullptr);
+	}
 	m_canvas->reset();
 }
 void SvgEditor::openFile()
@@ -353,140 +417,126 @@ void SvgEditor::openFile()
 	QString fileName = QFileDialog::getOpenFileName(this
 		, QString::fromLocal8Bit("ļ")
 		, QDir::currentPath()
-		, QString::fromLocal8Bit("(*.svg)"));
+		, QString::fromLocal8Bit("(*.svg *.svgz *.sved)"));
 	if (fileName.isEmpty())
 		return;
 	newFile();
-	QFile file(fileName);
-	file.open(QIODevice::ReadOnly);
-	parseSvg(&file);
-	file.close();
-}
-void SvgEditor::parseSvg(QFile* file)
-{
-	QXmlStreamReader reader(file);
-	while (!reader.atEnd() && !reader.hasError())
-	{
-		QXmlStreamReader::TokenType token = reader.readNext();
-		if (token == QXmlStreamReader::StartElement)
+	SvgLoader* loader = new SvgLoader(this);
+	setLoader(loader);
+	// The loader signals from its worker threads; the context queues them to the GUI thread.
+	connect(loader, &SvgLoader::pageSizeParsed, this, [this, loader](int width, int height)
 		{
-			QRectF rect;
-			QPainterPath path;
-			Type type = Type::None;
-			if (reader.name() == "svg")
-			{
-				m_canvas->setSize(reader.attributes().value("width").toString().toInt()
-					, reader.attributes().value("height").toString().toInt());
-			}
-			if (reader.name() == "line")
-			{
-				qreal x1 = reader.attributes().value("x1").toString().toDouble();
-				qreal y1 = reader.attributes().value("y1").toString().toDouble();
-				qreal x2 = reader.attributes().value("x2").toString().toDouble();
-				qreal y2 = reader.attributes().value("y2").toString().toDouble();
-				rect.setTopLeft(QPointF(x1, y1));
-				rect.setBottomRight(QPointF(x2, y2));
-				type = Type::Line;
-			}
-			if (reader.name() == "path")
+			if (m_loader == loader)
+				m_canvas->setSize(width, height);
+		});
+	connect(loader, &SvgLoader::backGroundColorParsed, this, [this, loader](const QColor& color)
+		{
+			if (m_loader == loader)
+				m_canvas->setBackGroundColor(color);
+		});
+	connect(loader, &SvgLoader::itemsReady, this, [this, loader]
+		{
+			if (m_loader == loader)
+				m_canvas->appendItems(loader->takeItems());
+		});
+	connect(loader, &SvgLoader::progress, this, [this, loader](qint64 bytes, qint64 total)
+		{
+			if (m_loader == loader && total > 0)
+				ui.statusBar->showMessage(QString::fromLocal8Bit("ڴļ %1%").arg(qMin<qint64>(bytes * 100 / total, 100)));
+		});
+	connect(loader, &SvgLoader::finished, this, [this, loader](bool ok)
+		{
+			if (m_loader == loader)
 			{
-				QString pathStr = reader.attributes().value("d").toString().toUpper();
-				pathStr.remove(" ");
-				int n = pathStr.indexOf("L");
-				QString str = pathStr.mid(1, n - 1);
-				int i = str.indexOf(",");
-				path.moveTo(QPointF(str.mid(0, i).toDouble(), str.mid(i + 1).toDouble()));
-				pathStr.remove(0, n + 1);
-				while (pathStr.indexOf("L") != -1)
-				{
-					n = pathStr.indexOf("L");
-					str = pathStr.left(n);
-					i = str.indexOf(",");
-					path.lineTo(QPointF(str.mid(0, i).toDouble(), str.mid(i + 1).toDouble()));
-					pathStr.remove(0, n + 1);
-				}
-				if (pathStr.indexOf("Z") != -1)
-				{
-					pathStr.remove("Z");
-					i = pathStr.indexOf(",");
-					path.lineTo(QPointF(pathStr.mid(0, i).toDouble(), pathStr.mid(i + 1).toDouble()));
-					path.closeSubpath();
-				}
+				m_canvas->appendItems(loader->takeItems());
+				if (ok)
+					ui.statusBar->clearMessage();
 				else
-				{
-					i = pathStr.indexOf(",");
-					path.lineTo(QPointF(pathStr.mid(0, i).toDouble(), pathStr.mid(i + 1).toDouble()));
-				}
-				rect = path.boundingRect();
-				type = Type::Path;
-			}
-			if (reader.name() == "ellipse")
-			{
-				qreal cx = reader.attributes().value("cx").toString().toDouble();
-				qreal cy = reader.attributes().value("cy").toString().toDouble();
-				qreal rx = reader.attributes().value("rx").toString().toDouble();
-				qreal ry = reader.attributes().value("ry").toString().toDouble();
-				rect = QRectF(cx - rx, cy - ry, 2 * rx, 2 * ry);
-				type = Type::Ellipse;
-			}
-			if (reader.name() == "rect")
-			{
-				qreal x = reader.attributes().value("x").toString().toDouble();
-				qreal y = reader.attributes().value("y").toString().toDouble();
-				qreal width = reader.attributes().value("width").toString().toDouble();
-				qreal height = reader.attributes().value("height").toString().toDouble();
-				rect = QRectF(x, y, width, height);
-				type = Type::Rect;
+					ui.statusBar->showMessage(QString::fromLocal8Bit("ļʧ: ") + loader->getErrorString(), 3000);
+				setLoader(nullptr);
 			}
-			if (type != Type::None)
-			{
-				QString stroke = reader.attributes().value("stroke").toString();
-				qreal strokeWidth = reader.attributes().value("stroke-width").toString().toDouble();
-				QString strokeDashArray = reader.attributes().value("stroke-dasharray").toString();
-				Qt::PenStyle style = Qt::PenStyle::SolidLine;
-				if (strokeDashArray == "10,5")
-					style = Qt::PenStyle::DashLine;
-				if (strokeDashArray == "1,5")
-					style = Qt::PenStyle::DotLine;
-				if (strokeDashArray == "10,5,1,5")
-					style = Qt::PenStyle::DashDotLine;
-				if (strokeDashArray == "10,5,1,5,1,5")
-					style = Qt::PenStyle::DashDotDotLine;
-				QPen pen(QColor(stroke), strokeWidth, style);
-				QBrush brush = QBrush(QColor(reader.attributes().value("fill").toString()));
-				m_canvas->getManager()->createItem(type, rect, path, pen, brush);
-			}
-		}
-	}
+			loader->deleteLater();
+		});
+	loader->start(fileName);
 }
 void SvgEditor::saveFile()
 {
+	// Items still arrive while a file is opening, so the document is not complete yet.
+	if (m_loader != nullptr)
+		return;
 	QString fileName = QFileDialog::getSaveFileName(this
 		, QString::fromLocal8Bit("ļ")
 		, QDir::currentPath()
-		, QString::fromLocal8Bit("(*.svg)"));
+		, QString::fromLocal8Bit("(*.svg);;(*.svgz);;(*.sved)"));
 	if (fileName.isEmpty())
 		return;
-	QFile file(fileName);
-	file.open(QIODevice::WriteOnly);
-	QTextStream out(&file);
-	out << QString::fromStdString(m_canvas->toSvgText());
-	file.close();
+	QSaveFile file(fileName);
+	QString error;
+	bool ok = file.open(QIODevice::WriteOnly);
+	if (ok && fileName.endsWith(QString(".") + NativeFormat::Suffix, Qt::CaseInsensitive))
+	{
+		ok = NativeFormat::write(&file, *m_canvas->getManager(), QSize(m_canvas->getWidth(), m_canvas->getHeight()), m_canvas->getBackGroundColor());
+	}
+	else if (ok && fileName.endsWith(".svgz", Qt::CaseInsensitive))
+	{
+		GzipWriter gzip(&file);
+		ok = gzip.open(QIODevice::WriteOnly);
+		SvgWriter writer(&gzip);
+		m_canvas->writeSvg(writer);
+		ok = writer.flush() && ok;
+		gzip.close();
+		if (gzip.hasError())
+		{
+			error = gzip.errorString();
+			ok = false;
+		}
+	}
+	else if (ok)
+	{
+		SvgWriter writer(&file);
+		m_canvas->writeSvg(writer);
+		ok = writer.flush();
+	}
+	// An uncommitted QSaveFile is discarded, so a failed save never replaces the previous file.
+	if (ok)
+		ok = file.commit();
+	if (ok)
+		return;
+	if (error.isEmpty())
+		error = file.errorString();
+	QMessageBox::warning(this, QString::fromLocal8Bit("ļ"), QString::fromLocal8Bit("ļʧ: ") + error);
 }
 void SvgEditor::saveFileToPng()
 {
+	if (m_loader != nullptr)
+		return;
 	QString fileName = QFileDialog::getSaveFileName(this
 		, QString::fromLocal8Bit("ļ")
 		, QDir::currentPath()
 		, QString::fromLocal8Bit("(*.png)"));
 	if (fileName.isEmpty())
 		return;
-	QPixmap pixMap(m_canvas->getWidth(), m_canvas->getHeight());
-	QPainter painter(&pixMap);
-	painter.scale(1 / m_canvas->getScale(), 1 / m_canvas->getScale());
-	m_canvas->getManager()->cancelSelected();
-	m_canvas->render(&painter);
-	pixMap.save(fileName);
+	PngExporter* exporter = new PngExporter(*m_canvas->getManager(), QSize(m_canvas->getWidth(), m_canvas->getHeight()), m_canvas->getBackGroundColor(), this);
+	connect(exporter, &PngExporter::progress, this, [this](int rows, int total)
+		{
+			ui.statusBar->showMessage(QString::fromLocal8Bit("ڵPNG %1%").arg(static_cast<qint64>(rows) * 100 / total));
+		});
+	connect(exporter, &PngExporter::finished, this, [this, exporter](bool ok)
+		{
+			if (ok)
+				ui.statusBar->showMessage(QString::fromLocal8Bit("PNG"), 3000);
+			else
+				ui.statusBar->showMessage(QString::fromLocal8Bit("PNGʧ: ") + exporter->getErrorString(), 3000);
+			exporter->deleteLater();
+		});
+	exporter->start(fileName);
+}
+// Saving and exporting are disabled while a loader is still delivering items.
+void SvgEditor::setLoader(SvgLoader* loader)
+{
+	m_loader = loader;
+	m_saveAction->setEnabled(loader == nullptr);
+	m_exportAction->setEnabled(loader == nullptr);
 }
 bool SvgEditor::eventFilter(QObject* watched, QEvent* event)
 {
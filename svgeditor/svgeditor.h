@@ -5,6 +5,7 @@
 #include "ui_SvgEditor.h"
 
 #include "canvas.h"
+#include "svgloader.h"
 
 class SvgEditor : public QMainWindow
 {
@@ -22,11 +23,14 @@ protected:
 	void setLeftToobar();
 	void setTopMenuBar();
 	QWidget* getDatePanel();
-	void parseSvg(QFile* file);
 	virtual bool eventFilter(QObject* watched, QEvent* event) override;
 private:
+	void setLoader(SvgLoader* loader);
 	Ui::SvgEditorClass ui;
 	Canvas* m_canvas;
+	SvgLoader* m_loader;
+	QAction* m_saveAction;
+	QAction* m_exportAction;
 
 };
 
@@ -0,0 +1,550 @@
+#include "svgtest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <QBuffer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "commandhistory.h"
+#include "elementstore.h"
+#include "manager.h"
+#include "spatialindex.h"
+#include "svgwriter.h"
+#include "svgloader.h"
+#include "svgpathparser.h"
+
+namespace
+{
+	std::vector<ElementBase> load(const QString& fileName, int threads)
+	{
+		SvgLoader loader;
+		loader.setThreadCount(threads);
+		bool ok = loader.load(fileName);
+		if (!ok)
+			qWarning("%s", qPrintable(loader.getErrorString()));
+		return ok ? loader.takeItems() : std::vector<ElementBase>();
+	}
+
+	// Counts how far it has been redone, for history tests that need no document.
+	class Step :public Command
+	{
+	public:
+		explicit Step(int& value)
+			: m_value(value)
+		{
+			++m_value;
+		}
+		virtual void redo() override
+		{
+			++m_value;
+		}
+		virtual void undo() override
+		{
+			--m_value;
+		}
+	private:
+		int& m_value;
+	};
+
+	QByteArray write(double value, int precision)
+	{
+		QBuffer buffer;
+		buffer.open(QIODevice::WriteOnly);
+		SvgWriter writer(&buffer);
+		writer.setPrecision(precision);
+		writer << value;
+		writer.flush();
+		return buffer.data();
+	}
+
+	std::vector<QPointF> parse(const QString& data, bool* ok = nullptr)
+	{
+		QPainterPath path;
+		SvgPathParser parser(data.constData(), data.constData() + data.size());
+		bool parsed = parser.parse(path);
+		if (ok != nullptr)
+			*ok = parsed;
+		std::vector<QPointF> points;
+		for (int i = 0; i < path.elementCount(); ++i)
+			points.push_back(path.elementAt(i));
+		return points;
+	}
+
+	// The slots whose rect touches area, edges included, as the index promises them.
+	std::vector<size_t> scan(const std::map<size_t, QRectF>& rects, const QRectF& area)
+	{
+		std::vector<size_t> result;
+		for (const auto& pair : rects)
+		{
+			const QRectF& rect = pair.second;
+			if (rect.left() <= area.right() && area.left() <= rect.right() && rect.top() <= area.bottom() && area.top() <= rect.bottom())
+				result.push_back(pair.first);
+		}
+		return result;
+	}
+}
+
+// Random edits of the R-tree, each followed by queries compared against a linear scan. Splits,
+// underflowing removals, relabelling swaps and compaction all get exercised.
+void SvgTest::spatialIndexMatchesLinearScan()
+{
+	const size_t SlotCount = 400;
+	std::mt19937 random(20240607);
+	std::uniform_real_distribution<double> position(0, 1000);
+	std::uniform_real_distribution<double> extent(0, 40);
+	std::uniform_int_distribution<size_t> slot(0, SlotCount - 1);
+	auto randomRect = [&random, &position, &extent]
+	{
+		// Some rects have no width or height, as the bounds of horizontal and vertical lines do.
+		double width = random() % 8 == 0 ? 0 : extent(random);
+		double height = random() % 8 == 0 ? 0 : extent(random);
+		return QRectF(position(random), position(random), width, height);
+	};
+	SpatialIndex index;
+	std::map<size_t, QRectF> rects;
+	for (int step = 0; step < 4000; ++step)
+	{
+		size_t first = slot(random);
+		size_t second = slot(random);
+		switch (random() % 10)
+		{
+		case 0:
+		case 1:
+		case 2:
+		case 3:
+			if (rects.count(first) == 0)
+			{
+				rects[first] = randomRect();
+				index.insert(first, rects[first]);
+			}
+			break;
+		case 4:
+		case 5:
+			if (rects.count(first) != 0)
+			{
+				rects.erase(first);
+				index.remove(first);
+			}
+			break;
+		case 6:
+		case 7:
+			if (rects.count(first) != 0)
+			{
+				rects[first] = randomRect();
+				index.update(first, rects[first]);
+			}
+			break;
+		case 8:
+		{
+			bool hasFirst = rects.count(first) != 0;
+			bool hasSecond = rects.count(second) != 0;
+			QRectF firstRect = rects[first];
+			QRectF secondRect = rects[second];
+			rects.erase(first);
+			rects.erase(second);
+			if (hasSecond)
+				rects[first] = secondRect;
+			if (hasFirst)
+				rects[second] = firstRect;
+			index.swap(first, second);
+			break;
+		}
+		default:
+			if (random() % 20 == 0)
+			{
+				std::vector<size_t> map(SlotCount, std::numeric_limits<size_t>::max());
+				std::map<size_t, QRectF> remapped;
+				for (const auto& pair : rects)
+				{
+					map.at(pair.first) = remapped.size();
+					remapped[remapped.size()] = pair.second;
+				}
+				index.remap(map, SlotCount);
+				rects.swap(remapped);
+			}
+			break;
+		}
+		QCOMPARE(index.getCount(), rects.size());
+		QCOMPARE(index.contains(first), rects.count(first) != 0);
+		QRectF area = randomRect().adjusted(0, 0, 100, 100);
+		std::vector<size_t> found = index.query(area);
+		std::sort(found.begin(), found.end());
+		QCOMPARE(found, scan(rects, area));
+		QPointF point(position(random), position(random));
+		found = index.query(point, 5);
+		std::sort(found.begin(), found.end());
+		QCOMPARE(found, scan(rects, QRectF(point - QPointF(5, 5), point + QPointF(5, 5))));
+	}
+}
+
+// Numbers are written in fixed notation with the fewest digits that read back to the value, or to
+// the value rounded to the configured decimals; a rounded or negative zero is written as 0.
+void SvgTest::writerFormatsNumbers()
+{
+	QCOMPARE(write(12, -1), QByteArray("12"));
+	QCOMPARE(write(0.1, -1), QByteArray("0.1"));
+	QCOMPARE(write(-0.0, -1), QByteArray("0"));
+	QCOMPARE(write(-0.0004, 3), QByteArray("0"));
+	QCOMPARE(write(1.0 / 3, 2), QByteArray("0.33"));
+	QCOMPARE(write(-2.5, 0), QByteArray("-3"));
+	QCOMPARE(write(1e20, -1), QByteArray("100000000000000000000"));
+	QCOMPARE(write(1.5e-7, -1), QByteArray("0.00000015"));
+	std::mt19937 random(7);
+	std::uniform_real_distribution<double> mantissa(-10, 10);
+	std::uniform_int_distribution<int> exponent(-8, 8);
+	for (int i = 0; i < 10000; ++i)
+	{
+		double value = mantissa(random) * std::pow(10.0, exponent(random));
+		for (int precision : { -1, 0, 3, 6 })
+		{
+			QByteArray text = write(value, precision);
+			QVERIFY2(text.indexOf('e') < 0 && text.indexOf('E') < 0, text.constData());
+			bool ok = false;
+			double read = text.toDouble(&ok);
+			QVERIFY(ok);
+			if (precision < 0)
+				QCOMPARE(read, value);
+			else
+				QVERIFY2(std::abs(read - value) <= 0.5 * std::pow(10.0, -precision) + std::abs(value) * 1e-15, text.constData());
+		}
+	}
+}
+
+// Separators, signs, exponents, implicit commands and relative coordinates of the path grammar.
+// Curves and arcs are flattened, so they are checked by their end points and the side they bulge to.
+void SvgTest::pathParserReadsGrammar()
+{
+	typedef std::vector<QPointF> Points;
+	bool ok = false;
+	QCOMPARE(parse("M10,20L30-40", &ok), Points({ QPointF(10, 20), QPointF(30, -40) }));
+	QVERIFY(ok);
+	QCOMPARE(parse("M.5.5L1e1,-2E-1 +3 4"), Points({ QPointF(0.5, 0.5), QPointF(10, -0.2), QPointF(3, 4) }));
+	QCOMPARE(parse("m1 1 2 2h3v-1z"), Points({ QPointF(1, 1), QPointF(3, 3), QPointF(6, 3), QPointF(6, 2), QPointF(1, 1) }));
+	QCOMPARE(parse("M0 0L10 10Z m5 5 l1 0"), Points({ QPointF(0, 0), QPointF(10, 10), QPointF(0, 0), QPointF(5, 5), QPointF(6, 5) }));
+	QCOMPARE(parse("\tM 0 , 0\n H 4 V 4 "), Points({ QPointF(0, 0), QPointF(4, 0), QPointF(4, 4) }));
+	Points points = parse("M0." + QString(80, '0') + "1 2", &ok);
+	QVERIFY(ok);
+	QCOMPARE(points.size(), static_cast<size_t>(1));
+	QVERIFY(points.front().x() > 0 && points.front().x() < 1e-80);
+
+	// Malformed data keeps what was read before the error.
+	QCOMPARE(parse("M0 0L5 5L", &ok), Points({ QPointF(0, 0), QPointF(5, 5) }));
+	QVERIFY(!ok);
+	QPainterPath path;
+	QString bad("M0 0 X 1");
+	SvgPathParser parser(bad.constData(), bad.constData() + bad.size());
+	QVERIFY(!parser.parse(path));
+	QCOMPARE(parser.getErrorPosition(), 5);
+	QString truncated("M0 0L5");
+	SvgPathParser end(truncated.constData(), truncated.constData() + truncated.size());
+	QVERIFY(!end.parse(path));
+	QCOMPARE(end.getErrorPosition(), -1);
+
+	auto isAll = [](const Points& points, const std::function<bool(const QPointF&)>& test)
+	{
+		return std::all_of(points.begin(), points.end(), test);
+	};
+	points = parse("M0 0C0 10 10 10 10 0", &ok);
+	QVERIFY(ok && points.size() > 2);
+	QCOMPARE(points.back(), QPointF(10, 0));
+	QVERIFY(isAll(points, [](const QPointF& point) { return point.y() >= 0 && point.y() <= 7.5 + 1e-9; }));
+	points = parse("M0 0C0 10 10 10 10 0S20 -10 20 0");
+	QCOMPARE(points.back(), QPointF(20, 0));
+	QVERIFY(isAll(points, [](const QPointF& point) { return point.x() <= 10 || point.y() <= 1e-9; }));
+	points = parse("M0 0Q5 10 10 0t10 0");
+	QCOMPARE(points.back(), QPointF(20, 0));
+	QVERIFY(isAll(points, [](const QPointF& point) { return point.x() <= 10 ? point.y() >= -1e-9 : point.y() <= 1e-9; }));
+	// Sweeping the positive angle direction runs above the chord, as y points down.
+	for (QString arc : { "M0 0A5 5 0 0 1 10 0", "M0 0A1 1 0 0 1 10 0", "M0 0a5,5 0 0110,0" })
+	{
+		points = parse(arc, &ok);
+		QVERIFY(ok && points.size() > 2);
+		QCOMPARE(points.back(), QPointF(10, 0));
+		QVERIFY(isAll(points, [](const QPointF& point) { return std::abs(std::hypot(point.x() - 5, point.y()) - 5) < 1e-9 && point.y() <= 1e-9; }));
+	}
+	points = parse("M0 0a5,5 0 0010,0");
+	QVERIFY(isAll(points, [](const QPointF& point) { return point.y() >= -1e-9; }));
+}
+
+// A document written at a fixed precision loads back with every coordinate within that precision.
+void SvgTest::writtenDocumentReadsBack()
+{
+	const int Precision = 3;
+	// Ellipses and rects are read back from a center or corner and a size, each rounded by up to half
+	// a unit of the last decimal.
+	const double Tolerance = 1.5 * std::pow(10.0, -Precision);
+	CommandHistory::getInstance().clearAll();
+	Manager manager;
+	std::mt19937 random(11);
+	std::uniform_real_distribution<double> coordinate(-500, 500);
+	auto randomPoint = [&random, &coordinate]
+	{
+		return QPointF(coordinate(random), coordinate(random));
+	};
+	for (int i = 0; i < 400; ++i)
+	{
+		QPen pen(QColor(random() % 256, random() % 256, random() % 256), 0.25 + random() % 40 / 7.0);
+		QBrush brush(QColor(random() % 256, random() % 256, random() % 256));
+		QRectF rect(randomPoint(), randomPoint());
+		QPainterPath path;
+		switch (i % 4)
+		{
+		case 0:
+			manager.createItem(Type::Rect, rect.normalized(), path, pen, brush);
+			break;
+		case 1:
+			manager.createItem(Type::Ellipse, rect.normalized(), path, pen, brush);
+			break;
+		case 2:
+			manager.createItem(Type::Line, rect, path, pen, brush);
+			break;
+		default:
+			path.moveTo(randomPoint());
+			for (int j = 0; j < 20; ++j)
+				path.lineTo(randomPoint());
+			manager.createItem(Type::Path, path.boundingRect(), path, pen, brush);
+			break;
+		}
+	}
+	QTemporaryDir directory;
+	QVERIFY(directory.isValid());
+	QString fileName = directory.path() + "/written.svg";
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::WriteOnly));
+	{
+		SvgWriter writer(&file);
+		writer.setPrecision(Precision);
+		manager.writeSvg(writer, QSize(1000, 1000), Qt::white);
+		QVERIFY(writer.flush());
+	}
+	file.close();
+
+	auto isNear = [Tolerance](double a, double b)
+	{
+		return std::abs(a - b) <= Tolerance;
+	};
+	std::vector<ElementBase> items = load(fileName, 1);
+	const std::vector<std::shared_ptr<Element>>& written = manager.getItems();
+	QCOMPARE(items.size(), written.size());
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		const ElementBase& item = items.at(i);
+		const Element& original = *written.at(i);
+		QCOMPARE(item.getType(), original.getType());
+		QCOMPARE(item.getPen().color(), original.getPen().color());
+		QVERIFY(isNear(item.getPen().widthF(), original.getPen().widthF()));
+		QCOMPARE(item.getBrush().color(), original.getBrush().color());
+		QRectF rect = item.getBoungdingRect();
+		QRectF expected = original.getBoungdingRect();
+		QVERIFY(isNear(rect.left(), expected.left()) && isNear(rect.top(), expected.top()));
+		QVERIFY(isNear(rect.right(), expected.right()) && isNear(rect.bottom(), expected.bottom()));
+		if (item.getType() != Type::Path)
+			continue;
+		QCOMPARE(item.getPath().elementCount(), original.getPath().elementCount());
+		for (int j = 0; j < item.getPath().elementCount(); ++j)
+		{
+			QVERIFY(isNear(item.getPath().elementAt(j).x, original.getPath().elementAt(j).x));
+			QVERIFY(isNear(item.getPath().elementAt(j).y, original.getPath().elementAt(j).y));
+		}
+	}
+	CommandHistory::getInstance().clearAll();
+}
+
+// A document in the style of an Illustrator export: the namespace and the styles are entities of
+// the internal DTD subset, and it is large enough to be split into several chunks.
+void SvgTest::loadParallelWithEntities()
+{
+	const int Count = 20000;
+	QTemporaryDir directory;
+	QVERIFY(directory.isValid());
+	QString fileName = directory.path() + "/entities.svg";
+	QFile file(fileName);
+	QVERIFY(file.open(QIODevice::WriteOnly));
+	file.write("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+		"<!DOCTYPE svg PUBLIC \"-//W3C//DTD SVG 1.1//EN\" \"http://www.w3.org/Graphics/SVG/1.1/DTD/svg11.dtd\" [\n"
+		"\t<!ENTITY ns_svg \"http://www.w3.org/2000/svg\">\n"
+		"\t<!ENTITY st0 \"#0000ff\">\n"
+		"]>\n"
+		"<svg xmlns=\"&ns_svg;\" width=\"1000\" height=\"1000\">\n");
+	for (int i = 0; i < Count; ++i)
+	{
+		QByteArray x = QByteArray::number(i % 1000);
+		QByteArray y = QByteArray::number(i / 20);
+		switch (i % 4)
+		{
+		case 0:
+			file.write("<rect x=\"" + x + "\" y=\"" + y + "\" width=\"8\" height=\"4\" stroke=\"&st0;\" fill=\"&st0;\"/>\n");
+			break;
+		case 1:
+			file.write("<ellipse cx=\"" + x + "\" cy=\"" + y + "\" rx=\"3\" ry=\"5\" stroke=\"&st0;\" fill=\"none\"/>\n");
+			break;
+		case 2:
+			file.write("<line x1=\"" + x + "\" y1=\"" + y + "\" x2=\"0\" y2=\"0\" stroke=\"&st0;\"/>\n");
+			break;
+		default:
+			file.write("<g><path d=\"M" + x + " " + y + "L10 10L20 " + x + "\" stroke=\"&st0;\"/></g>\n");
+			break;
+		}
+	}
+	file.write("</svg>\n");
+	file.close();
+
+	std::vector<ElementBase> sequential = load(fileName, 1);
+	std::vector<ElementBase> parallel = load(fileName, 4);
+	QCOMPARE(sequential.size(), static_cast<size_t>(Count));
+	QCOMPARE(parallel.size(), sequential.size());
+	for (size_t i = 0; i < sequential.size(); ++i)
+	{
+		QCOMPARE(parallel.at(i).getType(), sequential.at(i).getType());
+		QCOMPARE(parallel.at(i).getBoungdingRect(), sequential.at(i).getBoungdingRect());
+		QVERIFY(parallel.at(i).getPath() == sequential.at(i).getPath());
+		QCOMPARE(parallel.at(i).getPen(), sequential.at(i).getPen());
+		QCOMPARE(parallel.at(i).getBrush(), sequential.at(i).getBrush());
+	}
+	QCOMPARE(sequential.front().getPen().color(), QColor(0, 0, 255));
+}
+
+// The history is shared by every document. Commands of a destroyed one must leave it, or a later
+// document created at the same address would be mistaken for it.
+void SvgTest::destroyedManagerLeavesHistory()
+{
+	CommandHistory& history = CommandHistory::getInstance();
+	history.clearAll();
+	Manager kept;
+	{
+		Manager removed;
+		kept.addItem(Type::Rect, QPointF(0, 0));
+		removed.addItem(Type::Rect, QPointF(10, 10));
+		kept.addItem(Type::Ellipse, QPointF(20, 20));
+		removed.addItem(Type::Line, QPointF(30, 30));
+		QCOMPARE(history.getCommandCount(), static_cast<size_t>(4));
+	}
+	QCOMPARE(history.getCommandCount(), static_cast<size_t>(2));
+	QCOMPARE(history.getUndoDepth(), static_cast<size_t>(2));
+	history.undo();
+	history.undo();
+	QCOMPARE(kept.getLiveCount(), static_cast<size_t>(0));
+	history.redo();
+	QCOMPARE(kept.getLiveCount(), static_cast<size_t>(1));
+	history.clearAll();
+}
+
+// A group of several commands puts the command index ahead of the group index. Recording after an
+// undo must then drop the undone groups by group index, or redo walks past the last command.
+void SvgTest::newCommandDropsRedoGroups()
+{
+	CommandHistory& history = CommandHistory::getInstance();
+	history.clearAll();
+	int value = 0;
+	history.addCommands({ std::make_shared<Step>(value), std::make_shared<Step>(value) });
+	for (int i = 0; i < 3; ++i)
+		history.addCommand(std::make_shared<Step>(value));
+	for (int i = 0; i < 3; ++i)
+		history.undo();
+	QCOMPARE(value, 2);
+	history.addCommand(std::make_shared<Step>(value));
+	history.redo();
+	QCOMPARE(value, 3);
+	QCOMPARE(history.getUndoDepth(), static_cast<size_t>(2));
+	QCOMPARE(history.getCommandCount(), static_cast<size_t>(3));
+	history.undo();
+	history.undo();
+	history.undo();
+	QCOMPARE(value, 0);
+	history.clearAll();
+}
+
+// Compaction renumbers the slots under the history. A tombstone whose only command was dropped by
+// a new action is freed; one a remaining command can restore keeps its element for undo and redo.
+void SvgTest::compactKeepsPinnedTombstones()
+{
+	CommandHistory& history = CommandHistory::getInstance();
+	history.clearAll();
+	Manager manager;
+	manager.addItem(Type::Rect, QPointF(0, 0));
+	manager.addItem(Type::Rect, QPointF(10, 10));
+	manager.removeItem();
+	manager.addItem(Type::Rect, QPointF(20, 20));
+	manager.addItem(Type::Rect, QPointF(30, 30));
+	history.undo();
+	manager.addItem(Type::Rect, QPointF(40, 40));
+	QCOMPARE(manager.getItems().size(), static_cast<size_t>(5));
+	QCOMPARE(manager.compact(), static_cast<size_t>(1));
+	QCOMPARE(manager.getItems().size(), static_cast<size_t>(4));
+	QCOMPARE(manager.getLiveCount(), static_cast<size_t>(3));
+	QCOMPARE(manager.itemsIn(QRectF(39, 39, 3, 3)).size(), static_cast<size_t>(1));
+	QVERIFY(manager.itemsIn(QRectF(29, 29, 3, 3)).empty());
+	for (int i = 0; i < 3; ++i)
+		history.undo();
+	QCOMPARE(manager.getLiveCount(), static_cast<size_t>(2));
+	QCOMPARE(manager.itemsIn(QRectF(9, 9, 3, 3)).size(), static_cast<size_t>(1));
+	history.undo();
+	QCOMPARE(manager.getLiveCount(), static_cast<size_t>(1));
+	for (int i = 0; i < 4; ++i)
+		history.redo();
+	QCOMPARE(manager.getLiveCount(), static_cast<size_t>(3));
+	QVERIFY(manager.itemsIn(QRectF(9, 9, 3, 3)).empty());
+	QCOMPARE(manager.itemsIn(QRectF(19, 19, 3, 3)).size(), static_cast<size_t>(1));
+	QCOMPARE(manager.itemsIn(QRectF(39, 39, 3, 3)).size(), static_cast<size_t>(1));
+	QCOMPARE(manager.compact(), static_cast<size_t>(0));
+	history.clearAll();
+}
+
+// A smoothed stroke trails the cursor while it is drawn; ending it must add the missing tail.
+void SvgTest::smoothedStrokeEndsAtCursor()
+{
+	CommandHistory::getInstance().clearAll();
+	Manager manager;
+	manager.setCaptureSmoothing(0.5);
+	manager.addItem(Type::Path, QPointF(0, 0));
+	manager.beginLiveEdit();
+	manager.drawItemShape(QPointF(10, 0));
+	manager.drawItemShape(QPointF(20, 0));
+	std::shared_ptr<Path> path = std::dynamic_pointer_cast<Path>(manager.getSelectedItem());
+	QVERIFY(path != nullptr);
+	QVERIFY(path->getPoints().back().x() < 20);
+	manager.endLiveEdit();
+	QCOMPARE(path->getPoints().back(), QPointF(20, 0));
+	QCOMPARE(path->getBoungdingRect().right(), 20.0);
+	CommandHistory::getInstance().clearAll();
+}
+
+// Dragging a pen width through its values restyles the same slots over and over; the style table
+// must only hold the styles still in use.
+void SvgTest::storeReleasesUnusedStyles()
+{
+	ElementStore store;
+	Rect first(QPointF(0, 0));
+	Rect second(QPointF(10, 10));
+	store.update(0, first);
+	store.update(1, second);
+	QCOMPARE(store.getStyleCount(), static_cast<size_t>(1));
+	for (int width = 1; width <= 100; ++width)
+	{
+		first.setPen(QPen(Qt::black, width));
+		store.update(0, first);
+	}
+	QCOMPARE(store.getStyleCount(), static_cast<size_t>(2));
+	QCOMPARE(store.getPen(store.getStyle(0)).widthF(), 100.0);
+	second.setPen(first.getPen());
+	store.update(1, second);
+	QCOMPARE(store.getStyleCount(), static_cast<size_t>(1));
+	QCOMPARE(store.getStyle(1), store.getStyle(0));
+	std::vector<size_t> map{ 0, std::numeric_limits<size_t>::max() };
+	store.remap(map, 1);
+	QCOMPARE(store.getStyleCount(), static_cast<size_t>(1));
+	map.assign(1, std::numeric_limits<size_t>::max());
+	store.remap(map, 0);
+	QCOMPARE(store.getStyleCount(), static_cast<size_t>(0));
+}
+
+QTEST_GUILESS_MAIN(SvgTest)
@@ -0,0 +1,24 @@
+#ifndef SVGTEST_H_
+#define SVGTEST_H_
+
+#include <QObject>
+
+// Regression tests of svgcore, run with QtTest: `svgtest` runs them all, `svgtest <name>` one of them.
+class SvgTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void spatialIndexMatchesLinearScan();
+	void writerFormatsNumbers();
+	void pathParserReadsGrammar();
+	void writtenDocumentReadsBack();
+	void loadParallelWithEntities();
+	void destroyedManagerLeavesHistory();
+	void newCommandDropsRedoGroups();
+	void compactKeepsPinnedTombstones();
+	void smoothedStrokeEndsAtCursor();
+	void storeReleasesUnusedStyles();
+};
+
+#endif // !SVGTEST_H_